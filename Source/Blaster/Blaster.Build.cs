@@ -39,7 +39,8 @@ public class Blaster : ModuleRules
 			"Blaster/Public/GameState",
 			"Blaster/Public/Pickups",
 			"Blaster/Public/LevelActors",
-			"Blaster/Public/PlayerStart"
+			"Blaster/Public/PlayerStart",
+			"Blaster/Public/Subsystems"
 		});
 	}
 }
@@ -3,4 +3,8 @@
 #include "Blaster.h"
 #include "Modules/ModuleManager.h"
 
+CSV_DEFINE_CATEGORY(Blaster, true);
+
+DEFINE_LOG_CATEGORY(LogBlaster);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Blaster, "Blaster" );
@@ -22,8 +22,150 @@
 #include "Projectile.h"
 #include "Shotgun.h"
 #include "BuffComp.h"
+#include "ProjectilePoolSubsystem.h"
 #include "CombatComponent.h"
 
+namespace
+{
+    // Muzzle offsets are sent in half centimetres, ten bits per component reach 2.5 metres from the actor
+    constexpr float ShotOriginScale = 2.f;
+    constexpr int32 ShotOriginMax = 511;
+
+    constexpr float OctahedralMax = 65535.f;
+
+    // Shots due further back than this were clamped by the fire schedule anyway
+    constexpr uint32 MaxShotTimeOffsetMs = 255;
+
+    float SignNotZero(float Value)
+    {
+        return Value >= 0.f ? 1.f : -1.f;
+    }
+
+    // Unit vector folded onto the octahedron and unfolded into the [-1, 1] square
+    FVector2D OctahedralEncode(const FVector& Direction)
+    {
+        const FVector N = Direction / (FMath::Abs(Direction.X) + FMath::Abs(Direction.Y) + FMath::Abs(Direction.Z));
+        if (N.Z >= 0.f) return FVector2D(N.X, N.Y);
+        return FVector2D((1.f - FMath::Abs(N.Y)) * SignNotZero(N.X), (1.f - FMath::Abs(N.X)) * SignNotZero(N.Y));
+    }
+
+    FVector OctahedralDecode(const FVector2D& Encoded)
+    {
+        FVector N(Encoded.X, Encoded.Y, 1.f - FMath::Abs(Encoded.X) - FMath::Abs(Encoded.Y));
+        if (N.Z < 0.f)
+        {
+            const double X = N.X;
+            N.X = (1.f - FMath::Abs(N.Y)) * SignNotZero(X);
+            N.Y = (1.f - FMath::Abs(X)) * SignNotZero(N.Y);
+        }
+        return N.GetSafeNormal();
+    }
+}  // namespace
+
+FShotRecord FShotRecord::Make(const FVector& ActorLocation, const FVector& Origin, const FVector& Target, EWeaponType WeaponType)
+{
+    FShotRecord Shot;
+    Shot.OriginOffset = Origin - ActorLocation;
+    Shot.AimDistance = static_cast<float>(FVector::Dist(Origin, Target));
+    Shot.AimDirection = Shot.AimDistance > UE_KINDA_SMALL_NUMBER ? (Target - Origin) / Shot.AimDistance : FVector::ForwardVector;
+    Shot.WeaponType = WeaponType;
+    if (Shot.IsShotgun())
+    {
+        Shot.ScatterOrigin = Origin;
+        Shot.ScatterTarget = Target;
+    }
+    return Shot;
+}
+
+bool FShotRecord::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    bOutSuccess = true;
+
+    uint32 Weapon = static_cast<uint32>(WeaponType);
+    Ar.SerializeInt(Weapon, static_cast<uint32>(EWeaponType::EWS_MAX) + 1);
+    if (Ar.IsLoading())
+    {
+        WeaponType = static_cast<EWeaponType>(Weapon);
+    }
+
+    uint32 TimeOffsetMs = 0;
+    if (Ar.IsSaving())
+    {
+        const int32 Ms = FMath::RoundToInt(TimeOffset * 1000.f);
+        TimeOffsetMs = static_cast<uint32>(FMath::Clamp(Ms, 0, static_cast<int32>(MaxShotTimeOffsetMs)));
+    }
+    Ar.SerializeInt(TimeOffsetMs, MaxShotTimeOffsetMs + 1);
+    if (Ar.IsLoading())
+    {
+        TimeOffset = TimeOffsetMs / 1000.f;
+    }
+
+    // The pellets depend on every bit of the muzzle and aim, they go as the client rolled them
+    if (IsShotgun())
+    {
+        bool bVectorSuccess = true;
+        ScatterOrigin.NetSerialize(Ar, Map, bVectorSuccess);
+        bOutSuccess &= bVectorSuccess;
+        ScatterTarget.NetSerialize(Ar, Map, bVectorSuccess);
+        bOutSuccess &= bVectorSuccess;
+        Ar << ScatterSeed;
+        return true;
+    }
+
+    // Ten bits per component while the muzzle is within reach of the actor, a full vector otherwise
+    uint32 Packed[3] = {0, 0, 0};
+    uint8 bPackedOrigin = 1;
+    if (Ar.IsSaving())
+    {
+        for (int32 i = 0; i < 3; ++i)
+        {
+            const int32 Value = FMath::RoundToInt(OriginOffset[i] * ShotOriginScale);
+            bPackedOrigin &= FMath::Abs(Value) <= ShotOriginMax ? 1 : 0;
+            Packed[i] = static_cast<uint32>(Value + ShotOriginMax);
+        }
+    }
+    Ar.SerializeBits(&bPackedOrigin, 1);
+    if (bPackedOrigin)
+    {
+        for (int32 i = 0; i < 3; ++i)
+        {
+            Ar.SerializeInt(Packed[i], 2 * ShotOriginMax + 1);
+            if (Ar.IsLoading())
+            {
+                OriginOffset[i] = (static_cast<int32>(Packed[i]) - ShotOriginMax) / ShotOriginScale;
+            }
+        }
+    }
+    else
+    {
+        bOutSuccess &= SerializePackedVector<100, 30>(OriginOffset, Ar);
+    }
+
+    // Sixteen bits per octahedral coordinate are well below a hundredth of a degree
+    uint16 Octahedral[2] = {0, 0};
+    if (Ar.IsSaving())
+    {
+        const FVector2D Encoded = OctahedralEncode(AimDirection);
+        Octahedral[0] = static_cast<uint16>(FMath::RoundToInt((Encoded.X * 0.5f + 0.5f) * OctahedralMax));
+        Octahedral[1] = static_cast<uint16>(FMath::RoundToInt((Encoded.Y * 0.5f + 0.5f) * OctahedralMax));
+    }
+    Ar << Octahedral[0];
+    Ar << Octahedral[1];
+    if (Ar.IsLoading())
+    {
+        AimDirection = OctahedralDecode(FVector2D(Octahedral[0] / OctahedralMax * 2.f - 1.f, Octahedral[1] / OctahedralMax * 2.f - 1.f));
+    }
+
+    uint32 Distance = Ar.IsSaving() ? static_cast<uint32>(FMath::RoundToInt(FMath::Max(AimDistance, 0.f))) : 0;
+    Ar.SerializeIntPacked(Distance);
+    if (Ar.IsLoading())
+    {
+        AimDistance = static_cast<float>(Distance);
+    }
+
+    return true;
+}
+
 UCombatComponent::UCombatComponent()
 {
     PrimaryComponentTick.bCanEverTick = true;
@@ -35,11 +177,10 @@ void UCombatComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActo
 
     if (BlasterCharacter && BlasterCharacter->IsLocallyControlled())
     {
-        FHitResult HitResult;
-        TraceUnderCrosshairs(HitResult);
-        HitTarget = HitResult.ImpactPoint;
+        UpdateAsyncTraces();
+        UpdateFireSchedule();
 
-        // DrawDebugSphere(GetWorld(), HitResult.ImpactPoint, 15.f, 12, FColor::Red, false, 0.1f);
+        // DrawDebugSphere(GetWorld(), HitTarget, 15.f, 12, FColor::Red, false, 0.1f);
 
         SetHUDCrosshairs(DeltaTime);
         InterpFOV(DeltaTime);
@@ -60,6 +201,10 @@ void UCombatComponent::BeginPlay()
     {
         InitializeCarriedAmmo();
     }
+    if (UProjectilePoolSubsystem* ProjectilePool = GetWorld() ? GetWorld()->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+    {
+        ProjectilePool->Prewarm(GrenadeClass);
+    }
 }
 
 void UCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -73,6 +218,7 @@ void UCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
     DOREPLIFETIME(UCombatComponent, CombatState);
     DOREPLIFETIME(UCombatComponent, Grenades);
     DOREPLIFETIME(UCombatComponent, Flag);
+    DOREPLIFETIME_CONDITION(UCombatComponent, FireState, COND_SkipOwner);
 }
 
 void UCombatComponent::EquipItem(ACarryItem* ItemToEquip)
@@ -659,22 +805,12 @@ void UCombatComponent::SpawnGrenade(const FVector_NetQuantize& Target)
     {
         const FVector StartingLocation = BlasterCharacter->GetAttachedGrenade()->GetComponentLocation();
         FVector ToTarget = Target - StartingLocation;
-        FActorSpawnParameters SpawnParams;
-        SpawnParams.Owner = BlasterCharacter;
-        SpawnParams.Instigator = BlasterCharacter;
-
-        AProjectile* Grenade = GetWorld()->SpawnActor<AProjectile>(  //
-            GrenadeClass,                                            //
-            StartingLocation,                                        //
-            ToTarget.Rotation(),                                     //
-            SpawnParams);
 
-        if (Grenade)
+        // Activation ignores the owner when moving
+        // TODO Use server side rewind algorithm
+        if (UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
         {
-            // TODO Use server side rewind algorithm
-            FCollisionQueryParams QueryParams;
-            QueryParams.AddIgnoredActor(SpawnParams.Owner);
-            Grenade->GetCollisionBox()->IgnoreActorWhenMoving(SpawnParams.Owner, true);
+            ProjectilePool->AcquireProjectile(GrenadeClass, StartingLocation, ToTarget.Rotation(), BlasterCharacter, BlasterCharacter);
         }
     }
 }
@@ -697,52 +833,126 @@ void UCombatComponent::PickupAmmo(EWeaponType WeaponType, uint32 AmmoAmount)
     }
 }
 
-void UCombatComponent::ServerFire_Implementation(
-    const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation, float FireDelay)
+void UCombatComponent::ServerFire_Implementation(const TArray<FShotRecord>& Shots)
 {
-    MulticastFire(TraceHitTarget, SocketLocation);
-}
+    if (!BlasterCharacter || !EquippedWeapon || !GetWorld()) return;
 
-bool UCombatComponent::ServerFire_Validate(
-    const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation, float FireDelay)
-{
-    if (EquippedWeapon)
+    // The client's own timing isn't trusted, the rate is measured on the server's receive timeline
+    const double Time = GetWorld()->GetTimeSeconds();
+    const float FireDelay = EquippedWeapon->FireDelay;
+    const float MaxShotCredit = FireDelay > 0.f ? 1.f + FireJitterAllowance / FireDelay : static_cast<float>(MaxShotsPerFrame);
+    if (ShotCreditWeapon != EquippedWeapon)
     {
-        bool bNearlyEqual = FMath::IsNearlyEqual(EquippedWeapon->FireDelay, FireDelay, 0.0001f);
-        return bNearlyEqual;
+        ShotCreditWeapon = EquippedWeapon;
+        ShotCredit = MaxShotCredit;
+    }
+    else if (FireDelay > 0.f)
+    {
+        ShotCredit = FMath::Min(ShotCredit + static_cast<float>(Time - ShotCreditTime) / FireDelay, MaxShotCredit);
+    }
+    else
+    {
+        ShotCredit = MaxShotCredit;
+    }
+    ShotCreditTime = Time;
+
+    // A listen server host fired and spent its rounds before sending, its shots are authoritative
+    const bool bRemote = !BlasterCharacter->IsLocallyControlled();
+    const FVector ActorLocation = BlasterCharacter->GetActorLocation();
+    for (const FShotRecord& Shot : Shots)
+    {
+        if (bRemote)
+        {
+            // Shots with another weapon raced a swap, shots past the credit came faster than the weapon fires
+            if (Shot.WeaponType != EquippedWeapon->GetWeaponType() || ShotCredit < 1.f)
+            {
+                RejectShot(Shot);
+                continue;
+            }
+            ShotCredit -= 1.f;
+
+            EquippedWeapon->SetShotTimeOffset(Shot.TimeOffset);
+            if (Shot.IsShotgun())
+            {
+                // The client's own quantized muzzle and aim, not rebuilt from the server's actor location
+                ShotgunLocalFire(Shot.GetTarget(ActorLocation), Shot.GetOrigin(ActorLocation), Shot.ScatterSeed);
+            }
+            else
+            {
+                LocalFire(Shot.GetTarget(ActorLocation), Shot.GetOrigin(ActorLocation));
+            }
+        }
+        ++FireState.ShotCounter;
+        FireState.Shot = Shot;
     }
-    return true;
 }
 
-void UCombatComponent::MulticastFire_Implementation(
-    const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation)
+bool UCombatComponent::ServerFire_Validate(const TArray<FShotRecord>& Shots)
 {
-    if (BlasterCharacter && BlasterCharacter->IsLocallyControlled()) return;
-    LocalFire(TraceHitTarget, SocketLocation);
+    return Shots.Num() <= MaxShotsPerFrame;
 }
 
-void UCombatComponent::ServerShotgunFire_Implementation(
-    const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation, float FireDelay)
+void UCombatComponent::RejectShot(const FShotRecord& Shot)
 {
-    MulticastShotgunFire(TraceHitTargets, SocketLocation);
+    // The client spent the round from the weapon it fired, which may be the secondary one after a swap. A weapon
+    // dropped since then has no round to give back, refunding another one would break its ammo sequence
+    AWeapon* FiredWeapon = nullptr;
+    if (EquippedWeapon && EquippedWeapon->GetWeaponType() == Shot.WeaponType)
+    {
+        FiredWeapon = EquippedWeapon;
+    }
+    else if (SecondaryWeapon && SecondaryWeapon->GetWeaponType() == Shot.WeaponType)
+    {
+        FiredWeapon = SecondaryWeapon;
+    }
+    if (FiredWeapon)
+    {
+        FiredWeapon->RefundRejectedRound();
+    }
 }
 
-bool UCombatComponent::ServerShotgunFire_Validate(
-    const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation, float FireDelay)
+void UCombatComponent::OnRep_FireState()
 {
-    if (EquippedWeapon)
+    const uint8 NewShots = FireState.ShotCounter - LastShotCounter;
+    LastShotCounter = FireState.ShotCounter;
+
+    // The first update only tells where the counter is, the shots behind it are long gone
+    if (!bFireStateReceived)
     {
-        bool bNearlyEqual = FMath::IsNearlyEqual(EquippedWeapon->FireDelay, FireDelay, 0.0001f);
-        return bNearlyEqual;
+        bFireStateReceived = true;
+        return;
+    }
+    if (!BlasterCharacter || BlasterCharacter->IsLocallyControlled() || NewShots == 0) return;
+
+    const bool bWasPlaying = ProxyShotsToPlay > 0;
+    ProxyShotsToPlay = FMath::Min<int32>(ProxyShotsToPlay + NewShots, MaxProxyShotsPerUpdate);
+    if (!bWasPlaying)
+    {
+        PlayProxyShot();
     }
-    return true;
 }
 
-void UCombatComponent::MulticastShotgunFire_Implementation(
-    const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation)
+void UCombatComponent::PlayProxyShot()
 {
-    if (BlasterCharacter && BlasterCharacter->IsLocallyControlled()) return;
-    ShotgunLocalFire(TraceHitTargets, SocketLocation);
+    if (ProxyShotsToPlay <= 0 || !BlasterCharacter || !EquippedWeapon) return;
+    --ProxyShotsToPlay;
+
+    // Cosmetic only, the muzzle is wherever the proxy's weapon is now
+    const FVector SocketLocation = GetWeaponSocketLocation();
+    const FVector ShotTarget = FireState.Shot.GetTarget(BlasterCharacter->GetActorLocation());
+    if (EquippedWeapon->GetWeaponType() == EWeaponType::EWT_Shotgun)
+    {
+        ShotgunLocalFire(ShotTarget, SocketLocation, FireState.Shot.ScatterSeed);
+    }
+    else
+    {
+        LocalFire(ShotTarget, SocketLocation);
+    }
+
+    if (ProxyShotsToPlay > 0)
+    {
+        BlasterCharacter->GetWorldTimerManager().SetTimer(ProxyShotTimer, this, &ThisClass::PlayProxyShot, EquippedWeapon->FireDelay);
+    }
 }
 
 void UCombatComponent::LocalFire(const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation)
@@ -754,14 +964,15 @@ void UCombatComponent::LocalFire(const FVector_NetQuantize100& TraceHitTarget, c
     }
 }
 
-void UCombatComponent::ShotgunLocalFire(const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation)
+void UCombatComponent::ShotgunLocalFire(
+    const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation, int32 ScatterSeed)
 {
     AShotgun* Shotgun = Cast<AShotgun>(EquippedWeapon);
     if (!Shotgun || !BlasterCharacter) return;
     if (CombatState == ECombatState::ECS_Reloading || CombatState == ECombatState::ECS_Unoccupied)
     {
         BlasterCharacter->PlayFireMontage(bAiming);
-        Shotgun->FireShotgun(TraceHitTargets, SocketLocation);
+        Shotgun->FireShotgun(TraceHitTarget, SocketLocation, ScatterSeed);
         CombatState = ECombatState::ECS_Unoccupied;
         bLocallyReloading = false;
     }
@@ -769,7 +980,64 @@ void UCombatComponent::ShotgunLocalFire(const TArray<FVector_NetQuantize100>& Tr
 
 void UCombatComponent::TraceUnderCrosshairs(FHitResult& TraceHitResult)
 {
-    if (!BlasterCharacter || !GEngine || !GEngine->GameViewport) return;
+    FVector Start;
+    FVector End;
+    if (!GetCrosshairTraceSegment(Start, End)) return;
+
+    GetWorld()->LineTraceSingleByChannel(TraceHitResult, Start, End, ECollisionChannel::ECC_Visibility);
+    HandleCrosshairHit(TraceHitResult, End);
+}
+
+void UCombatComponent::UpdateAsyncTraces()
+{
+    UWorld* World = GetWorld();
+    if (!World || !BlasterCharacter) return;
+    const float Time = World->GetTimeSeconds();
+
+    // Results of last frame's traces, they are only kept for the frame after
+    FTraceDatum TraceDatum;
+    if (World->QueryTraceData(CrosshairTraceHandle, TraceDatum))
+    {
+        FHitResult HitResult = TraceDatum.OutHits.IsEmpty() ? FHitResult() : TraceDatum.OutHits[0];
+        HandleCrosshairHit(HitResult, TraceDatum.End);
+        HitTarget = HitResult.ImpactPoint;
+        CrosshairTraceTime = Time;
+    }
+    if (World->QueryTraceData(WallTraceHandle, TraceDatum))
+    {
+        const bool bHitWall = !TraceDatum.OutHits.IsEmpty() && TraceDatum.OutHits[0].bBlockingHit;
+        WallTraceDistance =
+            bHitWall ? static_cast<float>((TraceDatum.OutHits[0].ImpactPoint - TraceDatum.Start).Size()) : TNumericLimits<float>::Max();
+        WallTraceTime = Time;
+    }
+
+    if (Time - CrosshairTraceTime > TraceResultTimeToLive)
+    {
+        FHitResult HitResult;
+        TraceUnderCrosshairs(HitResult);
+        HitTarget = HitResult.ImpactPoint;
+        CrosshairTraceTime = Time;
+    }
+
+    FVector Start;
+    FVector End;
+    if (GetCrosshairTraceSegment(Start, End))
+    {
+        CrosshairTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, ECC_Visibility);
+    }
+    if (EquippedWeapon)
+    {
+        FCollisionQueryParams CollisionParams;
+        CollisionParams.AddIgnoredActor(BlasterCharacter);
+        CollisionParams.AddIgnoredActor(EquippedWeapon);
+        WallTraceHandle = World->AsyncLineTraceByChannel(
+            EAsyncTraceType::Single, BlasterCharacter->GetActorLocation(), HitTarget, ECC_Visibility, CollisionParams);
+    }
+}
+
+bool UCombatComponent::GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd)
+{
+    if (!BlasterCharacter || !GEngine || !GEngine->GameViewport || !GetWorld()) return false;
     FVector2D ViewportSize;
     GEngine->GameViewport->GetViewportSize(ViewportSize);
     FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
@@ -777,28 +1045,30 @@ void UCombatComponent::TraceUnderCrosshairs(FHitResult& TraceHitResult)
     FVector CrosshairWorldDirection;
     bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(
         UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation, CrosshairWorldPosition, CrosshairWorldDirection);
+    if (!bScreenToWorld) return false;
+
+    OutStart = CrosshairWorldPosition;
+    float DistanceToCharacter = (BlasterCharacter->GetActorLocation() - OutStart).Size();
+    OutStart += CrosshairWorldDirection * (DistanceToCharacter + 80.f);
+    OutEnd = OutStart + CrosshairWorldDirection * TRACE_LENGTH;
+    return true;
+}
 
-    if (bScreenToWorld)
+void UCombatComponent::HandleCrosshairHit(FHitResult& TraceHitResult, const FVector& TraceEnd)
+{
+    if (TraceHitResult.GetActor() && TraceHitResult.GetActor()->Implements<UInteractWithCrosshairsInterface>())
     {
-        FVector Start = CrosshairWorldPosition;
-        float DistanceToCharacter = (BlasterCharacter->GetActorLocation() - Start).Size();
-        Start += CrosshairWorldDirection * (DistanceToCharacter + 80.f);
-        FVector End = Start + CrosshairWorldDirection * TRACE_LENGTH;
-        GetWorld()->LineTraceSingleByChannel(TraceHitResult, Start, End, ECollisionChannel::ECC_Visibility);
-        if (TraceHitResult.GetActor() && TraceHitResult.GetActor()->Implements<UInteractWithCrosshairsInterface>())
-        {
-            HUDPackage.CrosshairsColor = FLinearColor::Red;
-            CrosshairCharacterFactor = 0.7f;
-        }
-        else
-        {
-            HUDPackage.CrosshairsColor = FLinearColor::White;
-            CrosshairCharacterFactor = 0.f;
-        }
-        if (!TraceHitResult.bBlockingHit)
-        {
-            TraceHitResult.ImpactPoint = End;
-        }
+        HUDPackage.CrosshairsColor = FLinearColor::Red;
+        CrosshairCharacterFactor = 0.7f;
+    }
+    else
+    {
+        HUDPackage.CrosshairsColor = FLinearColor::White;
+        CrosshairCharacterFactor = 0.f;
+    }
+    if (!TraceHitResult.bBlockingHit)
+    {
+        TraceHitResult.ImpactPoint = TraceEnd;
     }
 }
 
@@ -931,19 +1201,61 @@ void UCombatComponent::InterpFOV(float DeltaTime)
 
 void UCombatComponent::Fire()
 {
-    if (CanFire())
+    if (!GetWorld()) return;
+    if (FireShot(GetWorld()->GetTimeSeconds()))
+    {
+        SendPendingShots();
+    }
+}
+
+bool UCombatComponent::FireShot(double ShotTime)
+{
+    if (!CanFire()) return false;
+    bCanFire = false;
+    if (!EquippedWeapon) return false;
+
+    NextShotTime = ShotTime + EquippedWeapon->FireDelay;
+    ShotTimeOffset = static_cast<float>(FMath::Max(GetWorld()->GetTimeSeconds() - ShotTime, 0.0));
+    EquippedWeapon->SetShotTimeOffset(ShotTimeOffset);
+
+    switch (EquippedWeapon->GetWeaponFireType())
+    {
+        case EFireType::EFT_Projectile: FireProjectileWeapon(); break;
+        case EFireType::EFT_HitScan: FireHitScanWeapon(); break;
+        case EFireType::EFT_Shotgun: FireShotgun(); break;
+    }
+    CrosshairShootingFactor = 0.85f;
+    return true;
+}
+
+void UCombatComponent::UpdateFireSchedule()
+{
+    if (bCanFire || !EquippedWeapon || !GetWorld()) return;
+    const double Time = GetWorld()->GetTimeSeconds();
+    if (NextShotTime > Time) return;
+
+    int32 ShotsThisFrame = 0;
+    while (!bCanFire && NextShotTime <= Time && ShotsThisFrame < MaxShotsPerFrame)
     {
-        bCanFire = false;
-        if (!EquippedWeapon) return;
-        switch (EquippedWeapon->GetWeaponFireType())
+        bCanFire = true;
+        if (bFireButtonPressed && EquippedWeapon->bAutomatic && FireShot(NextShotTime))
         {
-            case EFireType::EFT_Projectile: FireProjectileWeapon(); break;
-            case EFireType::EFT_HitScan: FireHitScanWeapon(); break;
-            case EFireType::EFT_Shotgun: FireShotgun(); break;
+            ++ShotsThisFrame;
         }
-        CrosshairShootingFactor = 0.85f;
-        StartFireTimer();
     }
+    if (!bCanFire && NextShotTime < Time)
+    {
+        NextShotTime = Time;
+    }
+    SendPendingShots();
+    ReloadEmptyWeapon();
+}
+
+void UCombatComponent::SendPendingShots()
+{
+    if (PendingShots.IsEmpty()) return;
+    ServerFire(PendingShots);
+    PendingShots.Reset();
 }
 
 FVector UCombatComponent::GetWeaponSocketLocation()
@@ -964,12 +1276,13 @@ void UCombatComponent::FireProjectileWeapon()
 {
     if (EquippedWeapon)
     {
-        HitTarget =
+        // Each shot scatters around the crosshair, not around the previous shot of the frame
+        const FVector ShotTarget =
             EquippedWeapon->bUseScatter ? EquippedWeapon->TraceEndWithScatter(HitTarget, EquippedWeapon->GetTraceStart()) : HitTarget;
 
         FVector SocketLocation = GetWeaponSocketLocation();
-        LocalFire(HitTarget, SocketLocation);
-        ServerFire(HitTarget, SocketLocation, EquippedWeapon->FireDelay);
+        LocalFire(ShotTarget, SocketLocation);
+        PendingShots.Add(MakeShotRecord(SocketLocation, ShotTarget));
     }
 }
 
@@ -977,11 +1290,11 @@ void UCombatComponent::FireHitScanWeapon()
 {
     if (EquippedWeapon)
     {
-        HitTarget =
+        const FVector ShotTarget =
             EquippedWeapon->bUseScatter ? EquippedWeapon->TraceEndWithScatter(HitTarget, EquippedWeapon->GetTraceStart()) : HitTarget;
         FVector SocketLocation = GetWeaponSocketLocation();
-        LocalFire(HitTarget, SocketLocation);
-        ServerFire(HitTarget, SocketLocation, EquippedWeapon->FireDelay);
+        LocalFire(ShotTarget, SocketLocation);
+        PendingShots.Add(MakeShotRecord(SocketLocation, ShotTarget));
     }
 }
 
@@ -991,18 +1304,38 @@ void UCombatComponent::FireShotgun()
     {
         if (AShotgun* Shotgun = Cast<AShotgun>(EquippedWeapon))
         {
-            FVector SocketLocation = GetWeaponSocketLocation();
-            TArray<FVector_NetQuantize100> HitTargets;
-            Shotgun->ShotgunTraceEndWithScatter(HitTarget, HitTargets);
-            ShotgunLocalFire(HitTargets, SocketLocation);
-            ServerShotgunFire(HitTargets, SocketLocation, EquippedWeapon->FireDelay);
+            // Only the aim and the seed cross the wire, everyone rolls the same pellets from them
+            FVector_NetQuantize100 SocketLocation = GetWeaponSocketLocation();
+            FVector_NetQuantize100 ShotTarget = HitTarget;
+            AShotgun::QuantizeScatterInputs(ShotTarget, SocketLocation);
+            const int32 ScatterSeed = FMath::Rand();
+
+            ShotgunLocalFire(ShotTarget, SocketLocation, ScatterSeed);
+            FShotRecord& Shot = PendingShots.Add_GetRef(MakeShotRecord(SocketLocation, ShotTarget));
+            Shot.ScatterSeed = ScatterSeed;
         }
     }
 }
 
+FShotRecord UCombatComponent::MakeShotRecord(const FVector& SocketLocation, const FVector& TraceHitTarget) const
+{
+    if (!BlasterCharacter || !EquippedWeapon) return FShotRecord();
+    FShotRecord Shot =
+        FShotRecord::Make(BlasterCharacter->GetActorLocation(), SocketLocation, TraceHitTarget, EquippedWeapon->GetWeaponType());
+    Shot.TimeOffset = ShotTimeOffset;
+    return Shot;
+}
+
 bool UCombatComponent::IsCloseToWall()
 {
-    if (!BlasterCharacter || !EquippedWeapon) return true;
+    if (!BlasterCharacter || !EquippedWeapon || !GetWorld()) return true;
+
+    // The async wall trace of a recent frame answers without touching the scene
+    if (GetWorld()->GetTimeSeconds() - WallTraceTime <= TraceResultTimeToLive)
+    {
+        return WallTraceDistance <= EquippedWeapon->GetAllowedGapToWall();
+    }
+
     FVector Start = BlasterCharacter->GetActorLocation();
 
     FHitResult HitResult;
@@ -1018,23 +1351,6 @@ bool UCombatComponent::IsCloseToWall()
     return false;
 }
 
-void UCombatComponent::StartFireTimer()
-{
-    if (!EquippedWeapon || !BlasterCharacter) return;
-    BlasterCharacter->GetWorldTimerManager().SetTimer(FireTimer, this, &ThisClass::FireTimerFinished, EquippedWeapon->FireDelay);
-}
-
-void UCombatComponent::FireTimerFinished()
-{
-    if (!EquippedWeapon) return;
-    bCanFire = true;
-    if (bFireButtonPressed && EquippedWeapon->bAutomatic)
-    {
-        Fire();
-    }
-    ReloadEmptyWeapon();
-}
-
 bool UCombatComponent::CanFire()
 {
     //    Debug purpose
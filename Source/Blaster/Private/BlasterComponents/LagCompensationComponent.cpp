@@ -1,6 +1,5 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
-#include "Components/BoxComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "BlasterCharacter.h"
 #include "Engine/World.h"
@@ -15,750 +14,655 @@
 #include "HitScanWeapon.h"
 #include "ProjectileWeapon.h"
 #include "Projectile.h"
+#include "Shotgun.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
+#include "RewindSubsystem.h"
+#include "BlasterRewindMath.h"
 #include "LagCompensationComponent.h"
 
-ULagCompensationComponent::ULagCompensationComponent()
-{
-    PrimaryComponentTick.bCanEverTick = true;
-}
+DECLARE_CYCLE_STAT(TEXT("Rewind Projectile Path"), STAT_RewindProjectilePath, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Occlusion"), STAT_RewindOcclusion, STATGROUP_Blaster);
 
-void ULagCompensationComponent::BeginPlay()
+namespace
 {
-    Super::BeginPlay();
-}
+    // Claims a client can put in one bundle are bounded, so are their arrays
+    constexpr int32 MaxHitClaimCharacters = 64;
+    constexpr int32 MaxHitClaimLocations = 32;
 
-void ULagCompensationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-    SaveFramePackage();
-}
-
-void ULagCompensationComponent::ShowFramePackage(const FFramePackage& Package, const FColor& Color)
-{
-    for (auto& BoxInfo : Package.HitBoxInfo)
+    bool IsSequenceNewer(uint16 Sequence, uint16 Than)
     {
-        DrawDebugBox(GetWorld(), BoxInfo.Value.Location, BoxInfo.Value.BoxExtent, FQuat(BoxInfo.Value.Rotation), Color, false, 4.f);
+        return static_cast<int16>(Sequence - Than) > 0;
     }
-}
 
-FServerSideRewindResult ULagCompensationComponent::ServerSideRewind(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                            //
-    const FVector_NetQuantize100& HitLocation,                                                        //
-    float HitTime)
-{
-    FFramePackage FrameToCheck = GetFrameToCheck(HitCharacter, HitTime);
-    return ConfirmHit(FrameToCheck, HitCharacter, TraceStart, HitLocation);
-}
-
-FServerSideRewindResult ULagCompensationComponent::ProjectileServerSideRewind(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                                      //
-    const FVector_NetQuantize100& InitialVelocity,                                                              //
-    float GravityScale,                                                                                         //
-    float HitTime)
-{
-    FFramePackage FrameToCheck = GetFrameToCheck(HitCharacter, HitTime);
-    return ProjectileConfirmHit(FrameToCheck, HitCharacter, TraceStart, InitialVelocity, GravityScale, HitTime);
-}
-
-FExplosionProjectileServerSideRewindResult ULagCompensationComponent::ExplosionProjectileServerSideRewind(
-    const TArray<ABlasterCharacter*>& HitCharacters,  //
-    const FVector_NetQuantize& TraceStart,            //
-    const FVector_NetQuantize100& InitialVelocity,    //
-    float GravityScale,                               //
-    float DamageOuterRadius,                          //
-    float HitTime)
-{
-    TArray<FFramePackage> FramesToCheck;
-    for (ABlasterCharacter* HitCharacter : HitCharacters)
+    template <typename ElementType, typename SerializeElementType>
+    bool NetSerializeArray(FArchive& Ar, TArray<ElementType>& Array, int32 MaxNum, SerializeElementType&& SerializeElement)
     {
-        FramesToCheck.Add(GetFrameToCheck(HitCharacter, HitTime));
-    }
-    return ExplosionProjectileConfirmHit(FramesToCheck, TraceStart, InitialVelocity, GravityScale, DamageOuterRadius, HitTime);
-}
+        uint32 Num = Array.Num();
+        Ar.SerializeIntPacked(Num);
+        if (Num > static_cast<uint32>(MaxNum))
+        {
+            // The rest of the bunch can't be read past an oversized array, drop it
+            Ar.SetError();
+            return false;
+        }
 
-FShotgunServerSideRewindResult ULagCompensationComponent::ShotgunServerSideRewind(const TArray<ABlasterCharacter*>& HitCharacters,
-    const FVector_NetQuantize& TraceStart, const TArray<FVector_NetQuantize100>& HitLocations, float HitTime)
-{
-    TArray<FFramePackage> FramesToCheck;
-    for (ABlasterCharacter* HitCharacter : HitCharacters)
-    {
-        FramesToCheck.Add(GetFrameToCheck(HitCharacter, HitTime));
+        if (Ar.IsLoading())
+        {
+            Array.SetNum(Num);
+        }
+        bool bSuccess = true;
+        for (ElementType& Element : Array)
+        {
+            bSuccess &= SerializeElement(Element);
+        }
+        return bSuccess;
     }
-    return ShotgunConfirmHit(FramesToCheck, TraceStart, HitLocations);
-}
+}  // namespace
 
-FFramePackage ULagCompensationComponent::GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime)
+bool FHitClaim::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
 {
-    bool bReturn = HitCharacter == nullptr ||                                                         //
-                   HitCharacter->GetLagCompensationComponent() == nullptr ||                          //
-                   HitCharacter->GetLagCompensationComponent()->FrameHistory.GetHead() == nullptr ||  //
-                   HitCharacter->GetLagCompensationComponent()->FrameHistory.GetTail() == nullptr;    //
-
-    if (bReturn) return FFramePackage();
-
-    // Frame package that we check to verify a hit
-    FFramePackage FrameToCheck;
-    bool bShouldInterpolate = true;
-    // Frame history of the HitCharacter
-    const TDoubleLinkedList<FFramePackage>& History = HitCharacter->GetLagCompensationComponent()->FrameHistory;
-    const float OldestHistoryTime = History.GetTail()->GetValue().Time;
-    const float NewestHistoryTime = History.GetHead()->GetValue().Time;
-    if (OldestHistoryTime > HitTime)
-    {
-        // too far back - too laggy to do SSR
-        return FFramePackage();
-    }
-    if (FMath::IsNearlyEqual(OldestHistoryTime, HitTime))
-    {
-        FrameToCheck = History.GetTail()->GetValue();
-        bShouldInterpolate = false;
-    }
-    if (NewestHistoryTime <= HitTime)
+    bOutSuccess = true;
+    Ar << Sequence;
+
+    uint8 TypeBits = Ar.IsLoading() ? 0 : static_cast<uint8>(Type);
+    Ar.SerializeBits(&TypeBits, 2);
+    Type = static_cast<EScoreRequestType>(TypeBits);
+
+    bOutSuccess &= NetSerializeArray(Ar, HitCharacters, MaxHitClaimCharacters,
+        [&Ar, Map](ABlasterCharacter*& HitCharacter)
+        {
+            UObject* Object = HitCharacter;
+            const bool bSuccess = Map->SerializeObject(Ar, ABlasterCharacter::StaticClass(), Object);
+            HitCharacter = Cast<ABlasterCharacter>(Object);
+            return bSuccess;
+        });
+    if (Ar.IsError())
     {
-        FrameToCheck = History.GetHead()->GetValue();
-        bShouldInterpolate = false;
+        bOutSuccess = false;
+        return true;
     }
-    TDoubleLinkedList<FFramePackage>::TDoubleLinkedListNode* Younger = History.GetHead();
-    TDoubleLinkedList<FFramePackage>::TDoubleLinkedListNode* Older = Younger;
-    while (Older->GetValue().Time > HitTime)  // Is older still younger than HitTime ?
+    bool bVectorSuccess = true;
+    TraceStart.NetSerialize(Ar, Map, bVectorSuccess);
+
+    // Only what the claim's type uses goes on the wire
+    if (Type == EScoreRequestType::HitScan || Type == EScoreRequestType::Shotgun)
     {
-        // March back until: OlderTime < YoungerTime < YoungerTime
-        if (!Older->GetNextNode()) break;
-        Older = Older->GetNextNode();
-        if (Older->GetValue().Time > HitTime)
+        bOutSuccess &= NetSerializeArray(Ar, HitLocations, MaxHitClaimLocations,
+            [&Ar, Map](FVector_NetQuantize100& Location)
+            {
+                bool bSuccess = true;
+                return Location.NetSerialize(Ar, Map, bSuccess) && bSuccess;
+            });
+        if (Ar.IsError())
+        {
+            bOutSuccess = false;
+            return true;
+        }
+        if (Type == EScoreRequestType::Shotgun)
         {
-            Younger = Older;
+            Ar << ScatterSeed;
         }
     }
-    if (FMath::IsNearlyEqual(Older->GetValue().Time, HitTime))  // highly unlikely
+    else
     {
-        FrameToCheck = Older->GetValue();
-        bShouldInterpolate = false;
+        InitialVelocity.NetSerialize(Ar, Map, bVectorSuccess);
+        Ar << GravityScale;
     }
-    if (bShouldInterpolate)
+    if (Type == EScoreRequestType::ExplosionProjectile)
     {
-        // interpolate frames between Younger and Older
-        FrameToCheck = InterpBetweenFrames(Older->GetValue(), Younger->GetValue(), HitTime);
+        Ar << DamageInnerRadius;
+        Ar << DamageOuterRadius;
     }
-    FrameToCheck.Character = HitCharacter;
-    return FrameToCheck;
-}
+    Ar << HitTime;
+    Ar << Damage;
 
-FFramePackage ULagCompensationComponent::InterpBetweenFrames(  //
-    const FFramePackage& OlderFrame,                           //
-    const FFramePackage& YoungerFrame,                         //
-    float HitTime)
-{
-    const float Distance = YoungerFrame.Time - OlderFrame.Time;
-    const float InterpFraction = FMath::Clamp((HitTime - OlderFrame.Time) / Distance, 0.f, 1.f);
+    UObject* Causer = DamageCauser;
+    bOutSuccess &= Map->SerializeObject(Ar, AWeapon::StaticClass(), Causer);
+    DamageCauser = Cast<AWeapon>(Causer);
 
-    FFramePackage InterpFramePackage;
-    InterpFramePackage.Time = HitTime;
+    bOutSuccess &= bVectorSuccess;
+    return true;
+}
 
-    // Interpolate hit boxes
-    for (auto& YoungerPair : YoungerFrame.HitBoxInfo)
+bool FHitClaimAckWindow::MarkReceived(uint16 Sequence)
+{
+    if (!bReceivedAny)
     {
-        const FName& BoxInfoName = YoungerPair.Key;
-        if (OlderFrame.HitBoxInfo.Contains(BoxInfoName) && YoungerFrame.HitBoxInfo.Contains(BoxInfoName))
-        {
-            const FBoxInformation& OlderBox = OlderFrame.HitBoxInfo[BoxInfoName];
-            const FBoxInformation& YoungerBox = YoungerFrame.HitBoxInfo[BoxInfoName];
-
-            FBoxInformation InterpBoxInfo;
-            InterpBoxInfo.Location = FMath::VInterpTo(OlderBox.Location, YoungerBox.Location, 1.f, InterpFraction);
-            InterpBoxInfo.Rotation = FMath::RInterpTo(OlderBox.Rotation, YoungerBox.Rotation, 1.f, InterpFraction);
-            InterpBoxInfo.BoxExtent = YoungerBox.BoxExtent;
-
-            InterpFramePackage.HitBoxInfo.Add(BoxInfoName, InterpBoxInfo);
-        }
+        bReceivedAny = true;
+        Latest = Sequence;
+        Bits = 0;
+        return true;
     }
-    return InterpFramePackage;
-}
 
-void ULagCompensationComponent::ServerScoreRequest_Implementation(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                          //
-    const FVector_NetQuantize100& HitLocation,                                                      //
-    float HitTime,                                                                                  //
-    float Damage,                                                                                   //
-    AWeapon* DamageCauser                                                                           //
-)
-{
-    if (!BlasterCharacter || !HitCharacter || !DamageCauser) return;
-    FServerSideRewindResult Confirm = ServerSideRewind(HitCharacter, TraceStart, HitLocation, HitTime);
-    if (Confirm.bHitConfirmed)
+    if (IsSequenceNewer(Sequence, Latest))
     {
-        UGameplayStatics::ApplyDamage(          //
-            HitCharacter,                       //
-            Damage * Confirm.DamageModifier,    //
-            BlasterCharacter->GetController(),  //
-            DamageCauser,                       //
-            UDamageType::StaticClass()          //
-        );
+        // The previous latest becomes one of the bits
+        const uint16 Shift = Sequence - Latest;
+        Bits = Shift > 32 ? 0 : static_cast<uint32>(((static_cast<uint64>(Bits) << 1) | 1) << (Shift - 1));
+        Latest = Sequence;
+        return true;
     }
+
+    const uint16 Age = Latest - Sequence;
+    if (Age == 0 || Age > 32) return false;
+
+    const uint32 Bit = 1u << (Age - 1);
+    if (Bits & Bit) return false;
+    Bits |= Bit;
+    return true;
 }
 
-bool ULagCompensationComponent::ServerScoreRequest_Validate(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                    //
-    const FVector_NetQuantize100& HitLocation,                                                //
-    float HitTime,                                                                            //
-    float Damage,                                                                             //
-    AWeapon* DamageCauser)
+bool FHitClaimAckWindow::IsAcked(uint16 Sequence) const
 {
-    bool bIsValid = false;
-    if (AHitScanWeapon* HitScanWeapon = Cast<AHitScanWeapon>(DamageCauser))
-    {
-        bool bIsRightWeapon = HitScanWeapon->GetWeaponType() == EWeaponType::EWT_Pistol ||  //
-                              HitScanWeapon->GetWeaponType() == EWeaponType::EWT_SMG ||     //
-                              HitScanWeapon->GetWeaponType() == EWeaponType::EWT_SniperRifle;
+    if (!bReceivedAny) return false;
+    if (Sequence == Latest) return true;
+    if (IsSequenceNewer(Sequence, Latest)) return false;
 
-        if (bIsRightWeapon)
-        {
-            // Validate
-            bIsValid = FMath::IsNearlyEqual(Damage, HitScanWeapon->GetDamage(), 0.0001f);
-        }
-    }
+    const uint16 Age = Latest - Sequence;
+    return Age <= 32 && (Bits & (1u << (Age - 1))) != 0;
+}
 
-    return bIsValid;
+ULagCompensationComponent::ULagCompensationComponent()
+{
+    // Only ticks on the owning client while hit claims wait to be sent or acknowledged
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
 }
 
-void ULagCompensationComponent::ProjectileServerScoreRequest_Implementation(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                                    //
-    const FVector_NetQuantize100& InitialVelocity,                                                            //
-    float GravityScale,                                                                                       //
-    float HitTime,                                                                                            //
-    float Damage,                                                                                             //
-    AWeapon* DamageCauser                                                                                     //
-)
+void ULagCompensationComponent::BeginPlay()
 {
-    if (!BlasterCharacter || !HitCharacter || !DamageCauser) return;
-    FServerSideRewindResult Confirm = ProjectileServerSideRewind(HitCharacter, TraceStart, InitialVelocity, GravityScale, HitTime);
-    if (Confirm.bHitConfirmed)
+    Super::BeginPlay();
+    if (GetOwner() && GetOwner()->HasAuthority() && IsCharacterValid() && GetRewindSubsystem())
     {
-        UGameplayStatics::ApplyDamage(          //
-            HitCharacter,                       //
-            Damage * Confirm.DamageModifier,    //
-            BlasterCharacter->GetController(),  //
-            DamageCauser,                       //
-            UDamageType::StaticClass()          //
-        );
+        GetRewindSubsystem()->RegisterCharacter(BlasterCharacter);
     }
 }
 
-bool ULagCompensationComponent::ProjectileServerScoreRequest_Validate(ABlasterCharacter* HitCharacter,  //
-    const FVector_NetQuantize& TraceStart,                                                              //
-    const FVector_NetQuantize100& InitialVelocity,                                                      //
-    float GravityScale,                                                                                 //
-    float HitTime,                                                                                      //
-    float Damage,                                                                                       //
-    AWeapon* DamageCauser                                                                               //
-)
+void ULagCompensationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    bool bIsValid = false;
-    if (AProjectileWeapon* ProjectileWeapon = Cast<AProjectileWeapon>(DamageCauser))
+    if (BlasterCharacter && GetRewindSubsystem())
     {
-        bool bIsRightWeapon = ProjectileWeapon->GetWeaponType() == EWeaponType::EWT_AssaultRifle;
-        if (bIsRightWeapon && ProjectileWeapon->GetProjectileClass())
-        {
-            float Epsilon = 0.0001f;
-            UClass* ProjectileClass = ProjectileWeapon->GetProjectileClass().Get();
-            AProjectile* DefaultProjectile = ProjectileClass->GetDefaultObject<AProjectile>();
-            bool bIsRightProjectile = DefaultProjectile->GetProjectileType() == EProjectileType::EPT_ProjectileBullet;
-            if (bIsRightProjectile)
-            {
-                // Validate
-                bIsValid = FMath::IsNearlyEqual(Damage, DefaultProjectile->GetDamage(), Epsilon) &&         //
-                           FMath::IsNearlyEqual(GravityScale, DefaultProjectile->GravityScale, Epsilon) &&  //
-                           FMath::IsNearlyEqual(InitialVelocity.Size(), DefaultProjectile->InitialSpeed, 5.f);
-            }
-        }
+        GetRewindSubsystem()->UnregisterCharacter(BlasterCharacter);
     }
-
-    return bIsValid;
+    Super::EndPlay(EndPlayReason);
 }
 
-void ULagCompensationComponent::ExplosionProjectileServerScoreRequest_Implementation(  //
-    const TArray<ABlasterCharacter*>& HitCharacters,                                   //
-    const FVector_NetQuantize& TraceStart,
-    const FVector_NetQuantize100& InitialVelocity,  //
-    float GravityScale,                             //
-    float Damage,                                   //
-    float DamageInnerRadius,                        //
-    float DamageOuterRadius,                        //
-    AWeapon* DamageCauser,
-    float HitTime  //
-)
+URewindSubsystem* ULagCompensationComponent::GetRewindSubsystem() const
 {
-    if (!BlasterCharacter || !DamageCauser || HitCharacters.IsEmpty()) return;
-
-    FExplosionProjectileServerSideRewindResult Confirm =
-        ExplosionProjectileServerSideRewind(HitCharacters, TraceStart, InitialVelocity, GravityScale, DamageOuterRadius, HitTime);
-
-    UBlasterGameplayStatics::MakeRadialDamageWithFallOff(  //
-        Confirm.OverlapCharactersMap,                      //
-        TArray<AActor*>(HitCharacters),                    //
-        Confirm.Origin,                                    //
-        Damage,                                            //
-        DamageInnerRadius,                                 //
-        DamageOuterRadius,                                 //
-        BlasterCharacter->GetController(),                 //
-        DamageCauser);
+    return GetWorld() ? GetWorld()->GetSubsystem<URewindSubsystem>() : nullptr;
 }
 
-bool ULagCompensationComponent::ExplosionProjectileServerScoreRequest_Validate(  //
-    const TArray<ABlasterCharacter*>& HitCharacters,                             //
-    const FVector_NetQuantize& TraceStart,
-    const FVector_NetQuantize100& InitialVelocity,  //
-    float GravityScale,                             //
-    float Damage,                                   //
-    float DamageInnerRadius,                        //
-    float DamageOuterRadius,                        //
-    AWeapon* DamageCauser,
-    float HitTime  //
-)
+float ULagCompensationComponent::GetMaxRecordTime() const
 {
-    bool bIsValid = false;
-    if (AProjectileWeapon* ProjectileWeapon = Cast<AProjectileWeapon>(DamageCauser))
-    {
-        bool bIsRightWeapon = ProjectileWeapon->GetWeaponType() == EWeaponType::EWT_RocketLauncher;
-        if (bIsRightWeapon && ProjectileWeapon->GetProjectileClass())
-        {
-            float Epsilon = 0.0001f;
-            UClass* ProjectileClass = ProjectileWeapon->GetProjectileClass().Get();
-            AProjectile* DefaultProjectile = ProjectileClass->GetDefaultObject<AProjectile>();
-            bool bIsRightProjectile = DefaultProjectile->GetProjectileType() == EProjectileType::EPT_ProjectileRocket;
-
-            if (bIsRightProjectile)
-            {
-                // Validate
-                bIsValid = FMath::IsNearlyEqual(Damage, DefaultProjectile->GetDamage(), Epsilon) &&                        //
-                           FMath::IsNearlyEqual(DamageInnerRadius, DefaultProjectile->GetDamageInnerRadius(), Epsilon) &&  //
-                           FMath::IsNearlyEqual(DamageOuterRadius, DefaultProjectile->GetDamageOuterRadius(), Epsilon) &&  //
-                           FMath::IsNearlyEqual(GravityScale, DefaultProjectile->GravityScale, Epsilon) &&                 //
-                           FMath::IsNearlyEqual(InitialVelocity.Size(), DefaultProjectile->InitialSpeed, 5.f);             //
-            }
-        }
-    }
-
-    return bIsValid;
+    return GetRewindSubsystem() ? GetRewindSubsystem()->GetMaxRecordTime() : 4.f;
 }
 
-void ULagCompensationComponent::ShotgunServerScoreRequest_Implementation(const TArray<ABlasterCharacter*>& HitCharacters,  //
-    const FVector_NetQuantize& TraceStart,                                                                                 //
-    const TArray<FVector_NetQuantize100>& HitLocations,                                                                    //
-    float HitTime,                                                                                                         //
-    float Damage,
-    AWeapon* DamageCauser  //
-)
+void ULagCompensationComponent::ShowFramePackage(const FFramePackage& Package, const FColor& Color)
 {
-    if (HitCharacters.IsEmpty() || HitLocations.IsEmpty() || !DamageCauser || !BlasterCharacter) return;
-    FShotgunServerSideRewindResult Confirm = ShotgunServerSideRewind(HitCharacters, TraceStart, HitLocations, HitTime);
-
-    for (auto& HitCharacter : HitCharacters)
+    if (!Package.Character) return;
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
     {
-        if (HitCharacter && Confirm.Shots.Contains(HitCharacter))
-        {
-            float MultipleDamage = Confirm.Shots[HitCharacter] * Damage;
-            UGameplayStatics::ApplyDamage(          //
-                HitCharacter,                       //
-                MultipleDamage,                     //
-                BlasterCharacter->GetController(),  //
-                DamageCauser,                       //
-                UDamageType::StaticClass()          //
-            );
-        }
+        DrawDebugBox(GetWorld(), Package.Locations[Slot], Package.BoxExtents[Slot], Package.Rotations[Slot], Color, false, 4.f);
     }
 }
 
-bool ULagCompensationComponent::ShotgunServerScoreRequest_Validate(const TArray<ABlasterCharacter*>& HitCharacters,  //
-    const FVector_NetQuantize& TraceStart,                                                                           //
-    const TArray<FVector_NetQuantize100>& HitLocations,                                                              //
-    float HitTime,                                                                                                   //
-    float Damage,                                                                                                    //
-    AWeapon* DamageCauser)
+FFramePackage ULagCompensationComponent::GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime)
 {
-    bool bIsValid = false;
-    if (AHitScanWeapon* HitScanWeapon = Cast<AHitScanWeapon>(DamageCauser))
-    {
-        bool bIsRightWeapon = HitScanWeapon->GetWeaponType() == EWeaponType::EWT_Shotgun;
-        if (bIsRightWeapon)
-        {
-            // Validate
-            bIsValid = FMath::IsNearlyEqual(Damage, HitScanWeapon->GetDamage(), 0.0001f);
-        }
-    }
-
-    return bIsValid;
+    URewindSubsystem* RewindSubsystem = GetRewindSubsystem();
+    return RewindSubsystem ? RewindSubsystem->GetFrameToCheck(HitCharacter, HitTime) : FFramePackage();
 }
 
-FServerSideRewindResult ULagCompensationComponent::ConfirmHit(const FFramePackage& Package, ABlasterCharacter* HitCharacter,
-    const FVector_NetQuantize& TraceStart, const FVector_NetQuantize100& HitLocation)
+void ULagCompensationComponent::PrepareScoreRequest(const FScoreRequest& Request, FRewindJob& OutJob)
 {
-    FServerSideRewindResult ServerSideRewindResult;
-    ServerSideRewindResult.bHitConfirmed = false;
-
-    if (!HitCharacter) return ServerSideRewindResult;
-
-    FFramePackage CurrentFrame;
-    CacheBoxPositions(HitCharacter, CurrentFrame);
-    MoveBoxes(HitCharacter, Package);
+    if (!GetWorld()) return;
 
-    EnableCharacterMeshCollision(HitCharacter, ECollisionEnabled::NoCollision);
+    const bool bSingleTarget = Request.Type == EScoreRequestType::HitScan || Request.Type == EScoreRequestType::Projectile;
+    if (bSingleTarget && !IsValid(Request.HitCharacters[0])) return;
 
-    // EnableCollision for hit boxes
-    for (auto& HitBoxPair : HitCharacter->HitCollisionBoxes)
+    switch (Request.Type)
     {
-        if (HitBoxPair.Value)
+        case EScoreRequestType::HitScan:
+        case EScoreRequestType::Shotgun:
+        {
+            OutJob.Segments.Reserve(Request.HitLocations.Num());
+            for (const FVector_NetQuantize100& HitLocation : Request.HitLocations)
+            {
+                FRewindSegment& Segment = OutJob.Segments.AddDefaulted_GetRef();
+                Segment.Start = Request.TraceStart;
+                Segment.End = Request.TraceStart + (HitLocation - Request.TraceStart) * 1.25f;
+            }
+            break;
+        }
+        case EScoreRequestType::Projectile:
+        {
+            TraceProjectilePath(Request, OutJob);
+            break;
+        }
+        case EScoreRequestType::ExplosionProjectile:
         {
-            HitBoxPair.Value->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-            HitBoxPair.Value->SetCollisionResponseToChannel(ECC_HitBox, ECollisionResponse::ECR_Block);
-
-            // Debug purpose
-            // UE_LOG(LogTemp, Warning, TEXT("Component Location: %s"), *HitBoxPair.Value->GetComponentLocation().ToString());
-            // UE_LOG(LogTemp, Warning, TEXT("Scaled Box Extent: %s"), *HitBoxPair.Value->GetScaledBoxExtent().ToString());
-            // UE_LOG(LogTemp, Warning, TEXT("Component rotation: %s"), *HitBoxPair.Value->GetComponentRotation().ToString());
-            // DrawDebugBox(GetWorld(), HitBoxPair.Value->GetComponentLocation(), HitBoxPair.Value->GetUnscaledBoxExtent(),
-            //  FQuat(HitBoxPair.Value->GetComponentRotation()), FColor::Red, false, 4.f);
+            TraceProjectilePath(Request, OutJob);
+            OutJob.OverlapRadius = Request.DamageOuterRadius;
+            break;
         }
     }
 
-    FHitResult ConfirmHitResult;
-    const FVector TraceEnd = TraceStart + (HitLocation - TraceStart) * 1.25f;
-    UWorld* World = GetWorld();
-
-    if (World)
+    OutJob.Candidates.SetNum(Request.HitCharacters.Num());
+    for (int32 Index = 0; Index < Request.HitCharacters.Num(); ++Index)
     {
-        FCollisionQueryParams Params;
-        Params.bReturnPhysicalMaterial = true;
+        ABlasterCharacter* HitCharacter = Request.HitCharacters[Index];
 
-        World->LineTraceSingleByChannel(ConfirmHitResult, TraceStart, TraceEnd, ECC_HitBox, Params);
-        if (ConfirmHitResult.bBlockingHit && ConfirmHitResult.PhysMaterial.IsValid())
+        // Characters no shot got near keep an empty candidate, their frame is never interpolated
+        FFramePackage FrameToCheck;
+        if (bSingleTarget || IsInReach(HitCharacter, Request.HitTime, OutJob))
         {
-            UPhysicalMaterial* PhysMat = ConfirmHitResult.PhysMaterial.Get();
-            if (HitCharacter->DamageModifiers.Contains(PhysMat))
-            {
-                ServerSideRewindResult.bHitConfirmed = true;
-                ServerSideRewindResult.DamageModifier = HitCharacter->DamageModifiers[PhysMat];
-            }
+            FrameToCheck = GetFrameToCheck(HitCharacter, Request.HitTime);
         }
-    }
-    ResetHitBoxes(HitCharacter, CurrentFrame);
-    EnableCharacterMeshCollision(HitCharacter, ECollisionEnabled::QueryAndPhysics);
 
-    return ServerSideRewindResult;
+        // Without a frame to rewind to a single target is checked where it is now
+        if (bSingleTarget && !FrameToCheck.Character)
+        {
+            CacheBoxPositions(HitCharacter, FrameToCheck);
+        }
+        OutJob.Candidates[Index].Build(FrameToCheck, Request.TraceStart);
+    }
 }
 
-FServerSideRewindResult ULagCompensationComponent::ProjectileConfirmHit(const FFramePackage& Package,  //
-    ABlasterCharacter* HitCharacter,                                                                   //
-    const FVector_NetQuantize& TraceStart,                                                             //
-    const FVector_NetQuantize100& InitialVelocity,                                                     //
-    float GravityScale,                                                                                //
-    float HitTime)
+bool ULagCompensationComponent::IsInReach(ABlasterCharacter* HitCharacter, float HitTime, const FRewindJob& Job) const
 {
+    FBox Bounds;
+    URewindSubsystem* RewindSubsystem = GetRewindSubsystem();
+    if (!RewindSubsystem || !RewindSubsystem->GetBoundsToCheck(HitCharacter, HitTime, Bounds)) return false;
 
-    FServerSideRewindResult ServerSideRewindResult;
-    ServerSideRewindResult.bHitConfirmed = false;
-
-    if (!HitCharacter || !GetWorld()) return ServerSideRewindResult;
-
-    FFramePackage CurrentFrame;
-    CacheBoxPositions(HitCharacter, CurrentFrame);
-    MoveBoxes(HitCharacter, Package);
-    EnableCharacterMeshCollision(HitCharacter, ECollisionEnabled::NoCollision);
-
-    // EnableCollision for hit boxes
-    for (auto& HitBoxPair : HitCharacter->HitCollisionBoxes)
+    // A blast starts on the path or at its world hit and reaches OverlapRadius further
+    const float Reach = Job.SweepRadius + Job.OverlapRadius;
+    if (Job.OverlapRadius > 0.f && Job.bPathHitWorld && FMath::SphereAABBIntersection(Job.PathWorldHit, FMath::Square(Reach), Bounds))
     {
-        if (HitBoxPair.Value)
-        {
-            HitBoxPair.Value->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-            HitBoxPair.Value->SetCollisionResponseToChannel(ECC_HitBox, ECollisionResponse::ECR_Block);
-        }
+        return true;
     }
+    return BlasterRewindMath::SegmentsTouchBounds(Job.Segments, Bounds, Reach);
+}
+
+void ULagCompensationComponent::TraceProjectilePath(const FScoreRequest& Request, FRewindJob& OutJob)
+{
+    SCOPE_CYCLE_COUNTER(STAT_RewindProjectilePath);
 
+    // The path is traced against world geometry only, the rewound boxes are tested along its segments
     FPredictProjectilePathParams PathParams;
     PathParams.bTraceWithChannel = true;
     PathParams.bTraceWithCollision = true;
-    PathParams.MaxSimTime = MaxRecordTime;
-    PathParams.LaunchVelocity = InitialVelocity;
-    PathParams.StartLocation = TraceStart;
-    PathParams.OverrideGravityZ = GetWorld()->GetGravityZ() * GravityScale;
+    PathParams.MaxSimTime = GetMaxRecordTime();
+    PathParams.LaunchVelocity = Request.InitialVelocity;
+    PathParams.StartLocation = Request.TraceStart;
+    PathParams.OverrideGravityZ = GetWorld()->GetGravityZ() * Request.GravityScale;
     PathParams.SimFrequency = 15.f;
     PathParams.ProjectileRadius = 5.f;
-    PathParams.TraceChannel = ECC_HitBox;
+    PathParams.TraceChannel = ECollisionChannel::ECC_WorldStatic;
     PathParams.ActorsToIgnore.Add(GetOwner());
+    for (ABlasterCharacter* HitCharacter : Request.HitCharacters)
+    {
+        PathParams.ActorsToIgnore.Add(HitCharacter);
+    }
     PathParams.DrawDebugTime = 5.f;
     PathParams.DrawDebugType = EDrawDebugTrace::None;
 
     FPredictProjectilePathResult PathResult;
     UGameplayStatics::PredictProjectilePath(this, PathParams, PathResult);
 
-    if (PathResult.HitResult.bBlockingHit)
+    const TArray<FPredictProjectilePathPointData>& Path = PathResult.PathData;
+    OutJob.Segments.Reserve(FMath::Max(Path.Num() - 1, 0));
+    for (int32 PointIndex = 1; PointIndex < Path.Num(); ++PointIndex)
     {
-        UPrimitiveComponent* HitBoxComponent = PathResult.HitResult.GetComponent();
-        if (HitBoxComponent && HitBoxComponent->GetBodyInstance() && HitBoxComponent->GetBodyInstance()->GetSimplePhysicalMaterial())
-        {
-            UPhysicalMaterial* PhysMat = HitBoxComponent->GetBodyInstance()->GetSimplePhysicalMaterial();
-            if (HitCharacter->DamageModifiers.Contains(PhysMat))
-            {
-                ServerSideRewindResult.bHitConfirmed = true;
-                ServerSideRewindResult.DamageModifier = HitCharacter->DamageModifiers[PhysMat];
-            }
-        }
+        FRewindSegment& Segment = OutJob.Segments.AddDefaulted_GetRef();
+        Segment.Start = Path[PointIndex - 1].Location;
+        Segment.End = Path[PointIndex].Location;
     }
-
-    ResetHitBoxes(HitCharacter, CurrentFrame);
-    EnableCharacterMeshCollision(HitCharacter, ECollisionEnabled::QueryAndPhysics);
-
-    return ServerSideRewindResult;
+    OutJob.bSegmentsArePath = true;
+    OutJob.SweepRadius = PathParams.ProjectileRadius;
+    OutJob.bPathHitWorld = PathResult.HitResult.bBlockingHit;
+    OutJob.PathWorldHit = PathResult.HitResult.ImpactPoint;
 }
 
-FExplosionProjectileServerSideRewindResult ULagCompensationComponent::ExplosionProjectileConfirmHit(
-    const TArray<FFramePackage>& FramePackages,  //
-    const FVector_NetQuantize& TraceStart,
-    const FVector_NetQuantize100& InitialVelocity,  //
-    float GravityScale,                             //
-    float DamageOuterRadius,                        //
-    float HitTime                                   //
-)
+bool ULagCompensationComponent::FinishScoreRequest(const FScoreRequest& Request, const FRewindJob& Job, FRewindDamageBatch& OutBatch)
 {
-    FExplosionProjectileServerSideRewindResult ExplosionProjectileResult;
-    if (!GetWorld()) return ExplosionProjectileResult;
+    if (!IsValid(BlasterCharacter) || !IsValid(Request.DamageCauser)) return false;
 
-    TArray<FFramePackage> CurrentFrames;
-    // Cache
-    for (auto& Frame : FramePackages)
+    if (Request.Type == EScoreRequestType::ExplosionProjectile)
     {
-        FFramePackage CurrentFrame;
-        CacheBoxPositions(Frame.Character, CurrentFrame);
-        MoveBoxes(Frame.Character, Frame);
-        EnableCharacterMeshCollision(Frame.Character, ECollisionEnabled::NoCollision);
-        CurrentFrame.Character = Frame.Character;
-        CurrentFrames.Add(CurrentFrame);
-    }
+        if (!Job.bExploded) return false;
 
-    // EnableCollision for hit boxes
-    for (auto& Frame : FramePackages)
-    {
-        if (Frame.Character)
+        FConfirmedExplosion& Explosion = OutBatch.Explosions.AddDefaulted_GetRef();
+        Explosion.Result.Origin = Job.ExplosionOrigin;
+        for (int32 Index = 0; Index < Job.Overlaps.Num(); ++Index)
         {
-            for (auto& HitBoxPair : Frame.Character->HitCollisionBoxes)
-            {
-                if (HitBoxPair.Value)
-                {
-                    HitBoxPair.Value->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-                    HitBoxPair.Value->SetCollisionResponseToChannel(ECC_HitBox, ECollisionResponse::ECR_Overlap);
-                    HitBoxPair.Value->SetGenerateOverlapEvents(true);
-                }
-            }
+            const FRewindOverlap& Overlap = Job.Overlaps[Index];
+            ABlasterCharacter* HitCharacter = Request.HitCharacters[Index];
+            if (Overlap.Slot == INDEX_NONE || !IsValid(HitCharacter)) continue;
+            if (!HitCharacter->ActorHasTag("BlasterCharacter") || !HitCharacter->CanBeDamaged()) continue;
+
+            const FVector FakeHitNorm = (Job.ExplosionOrigin - Overlap.ClosestPoint).GetSafeNormal();
+            FHitResult Hit = FHitResult(HitCharacter, HitCharacter->GetMesh(), Overlap.ClosestPoint, FakeHitNorm);
+            Hit.BoneName = HitCharacter->GetHitBoxBoneName(Overlap.Slot);
+            Explosion.Result.OverlapCharactersMap.Add(HitCharacter, Hit);
         }
+        Explosion.HitCharacters = TArray<AActor*>(Request.HitCharacters);
+        Explosion.Damage = Request.Damage;
+        Explosion.DamageInnerRadius = Request.DamageInnerRadius;
+        Explosion.DamageOuterRadius = Request.DamageOuterRadius;
+        Explosion.InstigatorController = BlasterCharacter->GetController();
+        Explosion.DamageCauser = Request.DamageCauser;
+        return !Explosion.Result.OverlapCharactersMap.IsEmpty();
     }
 
-    FPredictProjectilePathParams PathParams;
-    PathParams.bTraceWithChannel = true;
-    PathParams.bTraceWithCollision = true;
-    PathParams.MaxSimTime = MaxRecordTime;
-    PathParams.LaunchVelocity = InitialVelocity;
-    PathParams.OverrideGravityZ = GetWorld()->GetGravityZ() * GravityScale;
-    PathParams.StartLocation = TraceStart;
-    PathParams.SimFrequency = 15.f;
-    PathParams.ProjectileRadius = 5.f;
-    PathParams.TraceChannel = ECollisionChannel::ECC_WorldStatic;
-    PathParams.ActorsToIgnore.Add(GetOwner());
-    PathParams.DrawDebugTime = 5.f;
-    PathParams.DrawDebugType = EDrawDebugTrace::None;
-
-    FPredictProjectilePathResult PathResult;
-    UGameplayStatics::PredictProjectilePath(this, PathParams, PathResult);
+    FCollisionQueryParams Params;
+    Params.AddIgnoredActor(GetOwner());
+    for (ABlasterCharacter* HitCharacter : Request.HitCharacters)
+    {
+        Params.AddIgnoredActor(HitCharacter);
+    }
 
-    if (PathResult.HitResult.bBlockingHit)
+    // Damage modifiers of every pellet that hit the same character add up to one hit
+    TMap<ABlasterCharacter*, float> DamageModifiers;
+    for (const FRewindShotHit& ShotHit : Job.ShotHits)
     {
-        ExplosionProjectileResult.Origin = PathResult.HitResult.ImpactPoint;
+        if (ShotHit.Slot == INDEX_NONE) continue;
+
+        ABlasterCharacter* HitCharacter = Request.HitCharacters[ShotHit.CandidateIndex];
+        if (!IsValid(HitCharacter)) continue;
+        if (Request.Type == EScoreRequestType::Shotgun && !HitCharacter->ActorHasTag("BlasterCharacter")) continue;
 
-        UBlasterGameplayStatics::GetOverlapActorsBySphereTrace(this, ExplosionProjectileResult.OverlapCharactersMap,
-            PathResult.HitResult.ImpactPoint, FName("BlasterCharacter"), ECC_HitBox, DamageOuterRadius);
+        // Projectiles already stopped on world geometry when their path was traced
+        if (!Job.bSegmentsArePath && IsOccluded(Request.TraceStart, ShotHit.ImpactPoint, Params)) continue;
 
-        // Debug
-        // DrawDebugSphere(GetWorld(), PathResult.HitResult.ImpactPoint, DamageOuterRadius, 20, FColor::Blue, true);
+        float DamageModifier = 1.f;
+        if (HitCharacter->GetHitBoxDamageModifier(ShotHit.Slot, DamageModifier))
+        {
+            DamageModifiers.FindOrAdd(HitCharacter) += DamageModifier;
+        }
     }
 
-    for (auto& Frame : CurrentFrames)
+    for (const auto& Modifier : DamageModifiers)
     {
-        ResetHitBoxes(Frame.Character, Frame);
-        EnableCharacterMeshCollision(Frame.Character, ECollisionEnabled::QueryAndPhysics);
+        OutBatch.Hits.Add({Modifier.Key, Request.Damage * Modifier.Value, BlasterCharacter->GetController(), Request.DamageCauser});
     }
-
-    return ExplosionProjectileResult;
+    return !DamageModifiers.IsEmpty();
 }
 
-FShotgunServerSideRewindResult ULagCompensationComponent::ShotgunConfirmHit(  //
-    const TArray<FFramePackage>& FramePackages,                               //
+void ULagCompensationComponent::ScoreRequest(ABlasterCharacter* HitCharacter,  //
     const FVector_NetQuantize& TraceStart,                                    //
-    const TArray<FVector_NetQuantize100>& HitLocations)
+    const FVector_NetQuantize100& HitLocation,                                //
+    float HitTime,                                                            //
+    float Damage,                                                             //
+    AWeapon* DamageCauser)
 {
-    FShotgunServerSideRewindResult ShotgunResult;
+    FHitClaim Claim;
+    Claim.Type = EScoreRequestType::HitScan;
+    Claim.HitCharacters.Add(HitCharacter);
+    Claim.TraceStart = TraceStart;
+    Claim.HitLocations.Add(HitLocation);
+    Claim.HitTime = HitTime;
+    Claim.Damage = Damage;
+    Claim.DamageCauser = DamageCauser;
+    QueueHitClaim(MoveTemp(Claim));
+}
 
-    if (!GetWorld()) return ShotgunResult;
+void ULagCompensationComponent::ProjectileScoreRequest(ABlasterCharacter* HitCharacter,  //
+    const FVector_NetQuantize& TraceStart,                                              //
+    const FVector_NetQuantize100& InitialVelocity,                                      //
+    float GravityScale,                                                                 //
+    float HitTime,                                                                      //
+    float Damage,                                                                       //
+    AWeapon* DamageCauser)
+{
+    FHitClaim Claim;
+    Claim.Type = EScoreRequestType::Projectile;
+    Claim.HitCharacters.Add(HitCharacter);
+    Claim.TraceStart = TraceStart;
+    Claim.InitialVelocity = InitialVelocity;
+    Claim.GravityScale = GravityScale;
+    Claim.HitTime = HitTime;
+    Claim.Damage = Damage;
+    Claim.DamageCauser = DamageCauser;
+    QueueHitClaim(MoveTemp(Claim));
+}
 
-    TArray<FFramePackage> CurrentFrames;
-    // Cache
-    for (auto& Frame : FramePackages)
-    {
-        FFramePackage CurrentFrame;
-        CacheBoxPositions(Frame.Character, CurrentFrame);
-        MoveBoxes(Frame.Character, Frame);
-        EnableCharacterMeshCollision(Frame.Character, ECollisionEnabled::NoCollision);
-        CurrentFrame.Character = Frame.Character;
-        CurrentFrames.Add(CurrentFrame);
-    }
+void ULagCompensationComponent::ExplosionProjectileScoreRequest(  //
+    const TArray<ABlasterCharacter*>& HitCharacters,             //
+    const FVector_NetQuantize& TraceStart,                       //
+    const FVector_NetQuantize100& InitialVelocity,               //
+    float GravityScale,                                          //
+    float Damage,                                                //
+    float DamageInnerRadius,                                     //
+    float DamageOuterRadius,                                     //
+    AWeapon* DamageCauser,                                       //
+    float HitTime)
+{
+    FHitClaim Claim;
+    Claim.Type = EScoreRequestType::ExplosionProjectile;
+    Claim.HitCharacters = HitCharacters;
+    Claim.TraceStart = TraceStart;
+    Claim.InitialVelocity = InitialVelocity;
+    Claim.GravityScale = GravityScale;
+    Claim.HitTime = HitTime;
+    Claim.Damage = Damage;
+    Claim.DamageInnerRadius = DamageInnerRadius;
+    Claim.DamageOuterRadius = DamageOuterRadius;
+    Claim.DamageCauser = DamageCauser;
+    QueueHitClaim(MoveTemp(Claim));
+}
 
-    // EnableCollision for hit boxes
-    for (auto& Frame : FramePackages)
-    {
-        if (Frame.Character)
-        {
-            for (auto& HitBoxPair : Frame.Character->HitCollisionBoxes)
-            {
-                if (HitBoxPair.Value)
-                {
-                    HitBoxPair.Value->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-                    HitBoxPair.Value->SetCollisionResponseToChannel(ECC_HitBox, ECollisionResponse::ECR_Block);
-                }
-            }
-        }
-    }
+void ULagCompensationComponent::ShotgunScoreRequest(    //
+    const TArray<ABlasterCharacter*>& HitCharacters,  //
+    const FVector_NetQuantize& TraceStart,            //
+    const FVector_NetQuantize100& HitTarget,          //
+    int32 ScatterSeed,                                //
+    float HitTime,                                    //
+    float Damage,                                     //
+    AWeapon* DamageCauser)
+{
+    FHitClaim Claim;
+    Claim.Type = EScoreRequestType::Shotgun;
+    Claim.HitCharacters = HitCharacters;
+    Claim.TraceStart = TraceStart;
+    Claim.HitLocations.Add(HitTarget);
+    Claim.ScatterSeed = ScatterSeed;
+    Claim.HitTime = HitTime;
+    Claim.Damage = Damage;
+    Claim.DamageCauser = DamageCauser;
+    QueueHitClaim(MoveTemp(Claim));
+}
 
-    for (auto& HitLocation : HitLocations)
+void ULagCompensationComponent::QueueHitClaim(FHitClaim&& Claim)
+{
+    if (!GetOwner()) return;
+
+    // A listen server host doesn't need the network
+    if (GetOwner()->HasAuthority())
     {
-        FHitResult ConfirmHitResult;
-        FCollisionQueryParams Params;
-        Params.bReturnPhysicalMaterial = true;
-        const FVector TraceEnd = TraceStart + (HitLocation - TraceStart) * 1.25f;
-        GetWorld()->LineTraceSingleByChannel(ConfirmHitResult, TraceStart, TraceEnd, ECC_HitBox, Params);
-        bool bHitCharacter = ConfirmHitResult.bBlockingHit &&  //
-                             ConfirmHitResult.GetActor() &&    //
-                             ConfirmHitResult.GetActor()->ActorHasTag("BlasterCharacter");
-        if (bHitCharacter && ConfirmHitResult.PhysMaterial.IsValid())
+        if (IsHitClaimValid(Claim))
         {
-            if (ABlasterCharacter* HitCharacter = Cast<ABlasterCharacter>(ConfirmHitResult.GetActor()))
-            {
-                UPhysicalMaterial* PhysMat = ConfirmHitResult.PhysMaterial.Get();
-                if (HitCharacter->DamageModifiers.Contains(PhysMat))
-                {
-                    if (ShotgunResult.Shots.Contains(HitCharacter))
-                    {
-                        ShotgunResult.Shots[HitCharacter] += HitCharacter->DamageModifiers[PhysMat];
-                    }
-                    else
-                    {
-                        ShotgunResult.Shots.Emplace(HitCharacter, HitCharacter->DamageModifiers[PhysMat]);
-                    }
-                }
-            }
+            QueueScoreRequest(Claim);
         }
+        return;
     }
 
-    for (auto& Frame : CurrentFrames)
-    {
-        ResetHitBoxes(Frame.Character, Frame);
-        EnableCharacterMeshCollision(Frame.Character, ECollisionEnabled::QueryAndPhysics);
-    }
-    return ShotgunResult;
+    Claim.Sequence = NextHitClaimSequence++;
+    PendingHitClaims.AddDefaulted_GetRef().Claim = MoveTemp(Claim);
+
+    // Ticks only while claims wait for their acknowledgement
+    SetComponentTickEnabled(true);
 }
 
-void ULagCompensationComponent::CacheBoxPositions(ABlasterCharacter* HitCharacter, FFramePackage& OutFramePackage)
+void ULagCompensationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
-    if (!HitCharacter) return;
-    for (auto& HitBoxPair : HitCharacter->HitCollisionBoxes)
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+    FlushHitClaims();
+}
+
+void ULagCompensationComponent::FlushHitClaims()
+{
+    if (!GetWorld()) return;
+
+    const float Time = GetWorld()->GetTimeSeconds();
+    PendingHitClaims.RemoveAll([this](const FPendingHitClaim& Pending) { return Pending.SendCount >= MaxHitClaimSends; });
+
+    // New claims and the ones whose acknowledgement is late go out in one bundle
+    TArray<FHitClaim> Bundle;
+    for (FPendingHitClaim& Pending : PendingHitClaims)
     {
-        if (HitBoxPair.Value)
-        {
-            FBoxInformation BoxInfo;
-            BoxInfo.Location = HitBoxPair.Value->GetComponentLocation();
-            BoxInfo.Rotation = HitBoxPair.Value->GetComponentRotation();
-            BoxInfo.BoxExtent = HitBoxPair.Value->GetUnscaledBoxExtent();
+        if (Bundle.Num() >= MaxHitClaimsPerBundle) break;
+        if (Pending.SendCount > 0 && Time - Pending.LastSendTime < HitClaimResendInterval) continue;
 
-            OutFramePackage.HitBoxInfo.Add(HitBoxPair.Key, BoxInfo);
-        }
+        Bundle.Add(Pending.Claim);
+        Pending.LastSendTime = Time;
+        ++Pending.SendCount;
+    }
+    if (!Bundle.IsEmpty())
+    {
+        ServerHitClaims(Bundle);
+    }
+
+    if (PendingHitClaims.IsEmpty())
+    {
+        SetComponentTickEnabled(false);
     }
 }
 
-void ULagCompensationComponent::MoveBoxes(ABlasterCharacter* HitCharacter, const FFramePackage& Package)
+void ULagCompensationComponent::ServerHitClaims_Implementation(const TArray<FHitClaim>& Claims)
 {
-    if (!HitCharacter) return;
-    for (auto& HitBoxPair : HitCharacter->HitCollisionBoxes)
+    for (const FHitClaim& Claim : Claims)
     {
-        if (HitBoxPair.Value && Package.HitBoxInfo.Contains(HitBoxPair.Key))
+        // Retransmitted claims that already made it are only acknowledged again. Invalid claims are acknowledged
+        // and dropped, a stale or destroyed weapon must not kick the client
+        if (ReceivedHitClaims.MarkReceived(Claim.Sequence) && IsHitClaimValid(Claim))
         {
-            HitBoxPair.Value->SetWorldLocation(Package.HitBoxInfo[HitBoxPair.Key].Location);
-            HitBoxPair.Value->SetWorldRotation(Package.HitBoxInfo[HitBoxPair.Key].Rotation);
-            HitBoxPair.Value->SetBoxExtent(Package.HitBoxInfo[HitBoxPair.Key].BoxExtent);
+            QueueScoreRequest(Claim);
         }
     }
+    ClientAckHitClaims(ReceivedHitClaims.Latest, ReceivedHitClaims.Bits);
 }
 
-void ULagCompensationComponent::ResetHitBoxes(ABlasterCharacter* HitCharacter, const FFramePackage& Package)
+bool ULagCompensationComponent::ServerHitClaims_Validate(const TArray<FHitClaim>& Claims)
 {
-    if (!HitCharacter) return;
-    for (auto& HitBoxPair : HitCharacter->HitCollisionBoxes)
+    // Only what no honest client can send, the claims themselves are checked one by one when received
+    if (Claims.Num() > MaxHitClaimsPerBundle) return false;
+    for (const FHitClaim& Claim : Claims)
     {
-        if (HitBoxPair.Value && Package.HitBoxInfo.Contains(HitBoxPair.Key))
-        {
-            HitBoxPair.Value->SetWorldLocation(Package.HitBoxInfo[HitBoxPair.Key].Location);
-            HitBoxPair.Value->SetWorldRotation(Package.HitBoxInfo[HitBoxPair.Key].Rotation);
-            HitBoxPair.Value->SetBoxExtent(Package.HitBoxInfo[HitBoxPair.Key].BoxExtent);
-
-            HitBoxPair.Value->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-        }
+        if (Claim.HitCharacters.Num() > MaxHitClaimCharacters || Claim.HitLocations.Num() > MaxHitClaimLocations) return false;
     }
+    return true;
 }
 
-void ULagCompensationComponent::EnableCharacterMeshCollision(ABlasterCharacter* HitCharacter, ECollisionEnabled::Type CollisionEnabled)
+void ULagCompensationComponent::ClientAckHitClaims_Implementation(uint16 Latest, uint32 Bits)
 {
-    if (!HitCharacter || !HitCharacter->GetMesh()) return;
-    HitCharacter->GetMesh()->SetCollisionEnabled(CollisionEnabled);
+    FHitClaimAckWindow Ack;
+    Ack.Latest = Latest;
+    Ack.Bits = Bits;
+    Ack.bReceivedAny = true;
+    PendingHitClaims.RemoveAll([&Ack](const FPendingHitClaim& Pending) { return Ack.IsAcked(Pending.Claim.Sequence); });
 }
 
-void ULagCompensationComponent::SaveFramePackage()
+void ULagCompensationComponent::QueueScoreRequest(const FHitClaim& Claim)
 {
-    if (!BlasterCharacter || !BlasterCharacter->HasAuthority()) return;
-    if (FrameHistory.Num() <= 1)
+    if (!BlasterCharacter || !Claim.DamageCauser || Claim.HitCharacters.IsEmpty() || !GetRewindSubsystem()) return;
+
+    FScoreRequest Request;
+    Request.Type = Claim.Type;
+    Request.Instigator = this;
+    Request.HitCharacters = Claim.HitCharacters;
+    Request.TraceStart = Claim.TraceStart;
+    if (Claim.Type == EScoreRequestType::Shotgun)
     {
-        FFramePackage ThisFrame;
-        SaveFramePackage(ThisFrame);
-        FrameHistory.AddHead(ThisFrame);
+        // The same pellets the client rolled, the seed and the quantized aim and muzzle fix them
+        AShotgun* Shotgun = Cast<AShotgun>(Claim.DamageCauser);
+        if (!Shotgun || Claim.HitLocations.IsEmpty()) return;
+        Shotgun->ShotgunTraceEndWithScatter(Claim.HitLocations[0], Claim.TraceStart, Claim.ScatterSeed, Request.HitLocations);
     }
     else
     {
-        float HistoryLength = FrameHistory.GetHead()->GetValue().Time - FrameHistory.GetTail()->GetValue().Time;
-        while (HistoryLength > MaxRecordTime)
+        Request.HitLocations = Claim.HitLocations;
+    }
+    Request.InitialVelocity = Claim.InitialVelocity;
+    Request.GravityScale = Claim.GravityScale;
+    Request.HitTime = Claim.HitTime;
+    Request.Damage = Claim.Damage;
+    Request.DamageInnerRadius = Claim.DamageInnerRadius;
+    Request.DamageOuterRadius = Claim.DamageOuterRadius;
+    Request.DamageCauser = Claim.DamageCauser;
+    GetRewindSubsystem()->QueueScoreRequest(MoveTemp(Request));
+}
+
+bool ULagCompensationComponent::IsHitClaimValid(const FHitClaim& Claim) const
+{
+    switch (Claim.Type)
+    {
+        case EScoreRequestType::HitScan:
+        case EScoreRequestType::Shotgun:
         {
-            FrameHistory.RemoveNode(FrameHistory.GetTail());
-            HistoryLength = FrameHistory.GetHead()->GetValue().Time - FrameHistory.GetTail()->GetValue().Time;
+            AHitScanWeapon* HitScanWeapon = Cast<AHitScanWeapon>(Claim.DamageCauser);
+            if (!HitScanWeapon) return false;
+
+            const EWeaponType WeaponType = HitScanWeapon->GetWeaponType();
+            bool bIsRightWeapon = WeaponType == EWeaponType::EWT_Shotgun;
+            if (Claim.Type == EScoreRequestType::HitScan)
+            {
+                bIsRightWeapon = WeaponType == EWeaponType::EWT_Pistol ||  //
+                                 WeaponType == EWeaponType::EWT_SMG ||     //
+                                 WeaponType == EWeaponType::EWT_SniperRifle;
+            }
+            const bool bIsRightShape = Claim.HitLocations.Num() == 1 &&  //
+                                       (Claim.Type == EScoreRequestType::Shotgun || Claim.HitCharacters.Num() == 1);
+
+            return bIsRightWeapon && bIsRightShape && FMath::IsNearlyEqual(Claim.Damage, HitScanWeapon->GetDamage(), 0.0001f);
         }
-        FFramePackage ThisFrame;
-        SaveFramePackage(ThisFrame);
-        FrameHistory.AddHead(ThisFrame);
+        case EScoreRequestType::Projectile:
+        case EScoreRequestType::ExplosionProjectile:
+        {
+            AProjectileWeapon* ProjectileWeapon = Cast<AProjectileWeapon>(Claim.DamageCauser);
+            if (!ProjectileWeapon || !ProjectileWeapon->GetProjectileClass()) return false;
+
+            const bool bExplosion = Claim.Type == EScoreRequestType::ExplosionProjectile;
+            const EWeaponType RightWeapon = bExplosion ? EWeaponType::EWT_RocketLauncher : EWeaponType::EWT_AssaultRifle;
+            const EProjectileType RightProjectile =
+                bExplosion ? EProjectileType::EPT_ProjectileRocket : EProjectileType::EPT_ProjectileBullet;
+            if (ProjectileWeapon->GetWeaponType() != RightWeapon) return false;
+            if (!bExplosion && Claim.HitCharacters.Num() != 1) return false;
 
-        // Debug purpose
-        // ShowFramePackage(ThisFrame, FColor::Red);
+            float Epsilon = 0.0001f;
+            UClass* ProjectileClass = ProjectileWeapon->GetProjectileClass().Get();
+            AProjectile* DefaultProjectile = ProjectileClass->GetDefaultObject<AProjectile>();
+            if (DefaultProjectile->GetProjectileType() != RightProjectile) return false;
+
+            // Validate
+            bool bIsValid = FMath::IsNearlyEqual(Claim.Damage, DefaultProjectile->GetDamage(), Epsilon) &&               //
+                            FMath::IsNearlyEqual(Claim.GravityScale, DefaultProjectile->GravityScale, Epsilon) &&        //
+                            FMath::IsNearlyEqual(Claim.InitialVelocity.Size(), DefaultProjectile->InitialSpeed, 5.f);  //
+            if (bExplosion)
+            {
+                bIsValid = bIsValid &&                                                                                         //
+                           FMath::IsNearlyEqual(Claim.DamageInnerRadius, DefaultProjectile->GetDamageInnerRadius(), Epsilon) &&  //
+                           FMath::IsNearlyEqual(Claim.DamageOuterRadius, DefaultProjectile->GetDamageOuterRadius(), Epsilon);
+            }
+            return bIsValid;
+        }
     }
+    return false;
 }
 
-void ULagCompensationComponent::SaveFramePackage(FFramePackage& Package)
+void ULagCompensationComponent::CacheBoxPositions(ABlasterCharacter* HitCharacter, FFramePackage& OutFramePackage)
 {
-    if (!IsCharacterValid()) return;
-    Package.Time = GetWorld()->GetTimeSeconds();
-    Package.Character = BlasterCharacter;
-    for (auto& BoxPair : BlasterCharacter->HitCollisionBoxes)
-    {
-        FBoxInformation BoxInformation;
-        BoxInformation.Location = BoxPair.Value->GetComponentLocation();
-        BoxInformation.Rotation = BoxPair.Value->GetComponentRotation();
-        BoxInformation.BoxExtent = BoxPair.Value->GetUnscaledBoxExtent();
+    if (!HitCharacter) return;
+    OutFramePackage.Character = HitCharacter;
+    HitCharacter->CaptureHitBoxes(OutFramePackage);
+    OutFramePackage.Bounds = BlasterRewindMath::ComputeBounds(OutFramePackage);
+}
 
-        Package.HitBoxInfo.Add(BoxPair.Key, BoxInformation);
-    }
+bool ULagCompensationComponent::IsOccluded(const FVector& Start, const FVector& End, const FCollisionQueryParams& Params) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_RewindOcclusion);
+
+    FHitResult OcclusionHit;
+    return GetWorld() && GetWorld()->LineTraceSingleByChannel(OcclusionHit, Start, End, ECollisionChannel::ECC_Visibility, Params);
 }
 
 bool ULagCompensationComponent::IsCharacterValid()
@@ -0,0 +1,317 @@
+#include "LagCompensationComponent.h"
+#include "BlasterCharacter.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "BlasterRewindMath.h"
+
+namespace
+{
+    // Rotates (X, Y, Z) by the inverse of the quaternion, lane by lane: T = 2 * (V x Q), V' = V + W * T + T x Q
+    FORCEINLINE void UnrotatePack(const VectorRegister4Float& QX,  //
+        const VectorRegister4Float& QY,                            //
+        const VectorRegister4Float& QZ,                            //
+        const VectorRegister4Float& QW,                            //
+        VectorRegister4Float& X,                                   //
+        VectorRegister4Float& Y,                                   //
+        VectorRegister4Float& Z)
+    {
+        const VectorRegister4Float Two = VectorSetFloat1(2.f);
+        const VectorRegister4Float TX = VectorMultiply(Two, VectorSubtract(VectorMultiply(Y, QZ), VectorMultiply(Z, QY)));
+        const VectorRegister4Float TY = VectorMultiply(Two, VectorSubtract(VectorMultiply(Z, QX), VectorMultiply(X, QZ)));
+        const VectorRegister4Float TZ = VectorMultiply(Two, VectorSubtract(VectorMultiply(X, QY), VectorMultiply(Y, QX)));
+
+        const VectorRegister4Float NewX =
+            VectorAdd(VectorMultiplyAdd(QW, TX, X), VectorSubtract(VectorMultiply(TY, QZ), VectorMultiply(TZ, QY)));
+        const VectorRegister4Float NewY =
+            VectorAdd(VectorMultiplyAdd(QW, TY, Y), VectorSubtract(VectorMultiply(TZ, QX), VectorMultiply(TX, QZ)));
+        const VectorRegister4Float NewZ =
+            VectorAdd(VectorMultiplyAdd(QW, TZ, Z), VectorSubtract(VectorMultiply(TX, QY), VectorMultiply(TY, QX)));
+        X = NewX;
+        Y = NewY;
+        Z = NewZ;
+    }
+
+    // Narrows [TNear, TFar] to the part of the segment S + t * D that lies between -E and E on one axis
+    FORCEINLINE void ClipSlab(const VectorRegister4Float& S,  //
+        const VectorRegister4Float& D,                        //
+        const VectorRegister4Float& E,                        //
+        VectorRegister4Float& TNear,                          //
+        VectorRegister4Float& TFar)
+    {
+        // A segment parallel to the slab gets an empty or an unbounded interval, depending on which side it starts
+        const VectorRegister4Float Epsilon = VectorSetFloat1(UE_KINDA_SMALL_NUMBER);
+        const VectorRegister4Float SafeD = VectorSelect(VectorCompareLT(VectorAbs(D), Epsilon), Epsilon, D);
+
+        const VectorRegister4Float T1 = VectorDivide(VectorSubtract(VectorNegate(E), S), SafeD);
+        const VectorRegister4Float T2 = VectorDivide(VectorSubtract(E, S), SafeD);
+        TNear = VectorMax(TNear, VectorMin(T1, T2));
+        TFar = VectorMin(TFar, VectorMax(T1, T2));
+    }
+}  // namespace
+
+void FRewindBoxes::Build(const FFramePackage& Package, const FVector& InOrigin)
+{
+    Origin = InOrigin;
+    ValidSlots = 0;
+
+    for (int32 Slot = 0; Slot < NumLanes; ++Slot)
+    {
+        const bool bValidSlot = Slot < HitBox::Num && Package.Character && Package.Character->HasHitBox(Slot);
+        if (!bValidSlot)
+        {
+            // Masked out by ValidSlots, only keep the lane finite
+            CenterX[Slot] = CenterY[Slot] = CenterZ[Slot] = 0.f;
+            QuatX[Slot] = QuatY[Slot] = QuatZ[Slot] = 0.f;
+            QuatW[Slot] = 1.f;
+            ExtentX[Slot] = ExtentY[Slot] = ExtentZ[Slot] = 0.f;
+            continue;
+        }
+
+        ValidSlots |= 1u << Slot;
+
+        const FVector3f Center(Package.Locations[Slot] - Origin);
+        CenterX[Slot] = Center.X;
+        CenterY[Slot] = Center.Y;
+        CenterZ[Slot] = Center.Z;
+
+        const FQuat4f Rotation(Package.Rotations[Slot]);
+        QuatX[Slot] = Rotation.X;
+        QuatY[Slot] = Rotation.Y;
+        QuatZ[Slot] = Rotation.Z;
+        QuatW[Slot] = Rotation.W;
+
+        const FVector3f Extent(Package.BoxExtents[Slot]);
+        ExtentX[Slot] = Extent.X;
+        ExtentY[Slot] = Extent.Y;
+        ExtentZ[Slot] = Extent.Z;
+    }
+}
+
+int32 BlasterRewindMath::SweepBoxes(const FRewindBoxes& Boxes,  //
+    const FVector& Start,                                         //
+    const FVector& End,                                           //
+    float Radius,                                                 //
+    float& OutHitFraction)
+{
+    const FVector3f LocalStart(Start - Boxes.Origin);
+    const FVector3f Delta(End - Start);
+    const VectorRegister4Float Inflate = VectorSetFloat1(Radius);
+
+    int32 HitSlot = INDEX_NONE;
+    float BestFraction = UE_MAX_FLT;
+    alignas(16) float EntryFractions[4];
+
+    for (int32 Pack = 0; Pack < FRewindBoxes::NumPacks; ++Pack)
+    {
+        const int32 First = Pack * 4;
+        const uint32 LaneMask = (Boxes.ValidSlots >> First) & 0xF;
+        if (!LaneMask) continue;
+
+        const VectorRegister4Float QX = VectorLoadAligned(&Boxes.QuatX[First]);
+        const VectorRegister4Float QY = VectorLoadAligned(&Boxes.QuatY[First]);
+        const VectorRegister4Float QZ = VectorLoadAligned(&Boxes.QuatZ[First]);
+        const VectorRegister4Float QW = VectorLoadAligned(&Boxes.QuatW[First]);
+
+        // Segment in the local space of each box
+        VectorRegister4Float SX = VectorSubtract(VectorSetFloat1(LocalStart.X), VectorLoadAligned(&Boxes.CenterX[First]));
+        VectorRegister4Float SY = VectorSubtract(VectorSetFloat1(LocalStart.Y), VectorLoadAligned(&Boxes.CenterY[First]));
+        VectorRegister4Float SZ = VectorSubtract(VectorSetFloat1(LocalStart.Z), VectorLoadAligned(&Boxes.CenterZ[First]));
+        UnrotatePack(QX, QY, QZ, QW, SX, SY, SZ);
+
+        VectorRegister4Float DX = VectorSetFloat1(Delta.X);
+        VectorRegister4Float DY = VectorSetFloat1(Delta.Y);
+        VectorRegister4Float DZ = VectorSetFloat1(Delta.Z);
+        UnrotatePack(QX, QY, QZ, QW, DX, DY, DZ);
+
+        VectorRegister4Float TNear = VectorZeroFloat();
+        VectorRegister4Float TFar = VectorSetFloat1(1.f);
+        ClipSlab(SX, DX, VectorAdd(VectorLoadAligned(&Boxes.ExtentX[First]), Inflate), TNear, TFar);
+        ClipSlab(SY, DY, VectorAdd(VectorLoadAligned(&Boxes.ExtentY[First]), Inflate), TNear, TFar);
+        ClipSlab(SZ, DZ, VectorAdd(VectorLoadAligned(&Boxes.ExtentZ[First]), Inflate), TNear, TFar);
+
+        const uint32 HitLanes = static_cast<uint32>(VectorMaskBits(VectorCompareLE(TNear, TFar))) & LaneMask;
+        if (!HitLanes) continue;
+
+        VectorStoreAligned(TNear, EntryFractions);
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            if ((HitLanes & (1u << Lane)) && EntryFractions[Lane] < BestFraction)
+            {
+                BestFraction = EntryFractions[Lane];
+                HitSlot = First + Lane;
+            }
+        }
+    }
+
+    OutHitFraction = HitSlot != INDEX_NONE ? BestFraction : 1.f;
+    return HitSlot;
+}
+
+int32 BlasterRewindMath::OverlapBoxes(const FRewindBoxes& Boxes, const FVector& Center, float Radius, FVector& OutClosestPoint)
+{
+    const FVector3f LocalCenter(Center - Boxes.Origin);
+    const VectorRegister4Float RadiusSquared = VectorSetFloat1(Radius * Radius);
+
+    int32 HitSlot = INDEX_NONE;
+    float BestDistanceSquared = UE_MAX_FLT;
+    FVector3f BestLocalPoint = FVector3f::ZeroVector;
+    alignas(16) float DistancesSquared[4];
+    alignas(16) float ClosestX[4];
+    alignas(16) float ClosestY[4];
+    alignas(16) float ClosestZ[4];
+
+    for (int32 Pack = 0; Pack < FRewindBoxes::NumPacks; ++Pack)
+    {
+        const int32 First = Pack * 4;
+        const uint32 LaneMask = (Boxes.ValidSlots >> First) & 0xF;
+        if (!LaneMask) continue;
+
+        // Sphere center in the local space of each box
+        VectorRegister4Float PX = VectorSubtract(VectorSetFloat1(LocalCenter.X), VectorLoadAligned(&Boxes.CenterX[First]));
+        VectorRegister4Float PY = VectorSubtract(VectorSetFloat1(LocalCenter.Y), VectorLoadAligned(&Boxes.CenterY[First]));
+        VectorRegister4Float PZ = VectorSubtract(VectorSetFloat1(LocalCenter.Z), VectorLoadAligned(&Boxes.CenterZ[First]));
+        UnrotatePack(VectorLoadAligned(&Boxes.QuatX[First]),  //
+            VectorLoadAligned(&Boxes.QuatY[First]),           //
+            VectorLoadAligned(&Boxes.QuatZ[First]),           //
+            VectorLoadAligned(&Boxes.QuatW[First]),           //
+            PX, PY, PZ);
+
+        // Closest point of the box is the center clamped to the extents
+        const VectorRegister4Float EX = VectorLoadAligned(&Boxes.ExtentX[First]);
+        const VectorRegister4Float EY = VectorLoadAligned(&Boxes.ExtentY[First]);
+        const VectorRegister4Float EZ = VectorLoadAligned(&Boxes.ExtentZ[First]);
+        const VectorRegister4Float CX = VectorMin(VectorMax(PX, VectorNegate(EX)), EX);
+        const VectorRegister4Float CY = VectorMin(VectorMax(PY, VectorNegate(EY)), EY);
+        const VectorRegister4Float CZ = VectorMin(VectorMax(PZ, VectorNegate(EZ)), EZ);
+
+        const VectorRegister4Float DX = VectorSubtract(PX, CX);
+        const VectorRegister4Float DY = VectorSubtract(PY, CY);
+        const VectorRegister4Float DZ = VectorSubtract(PZ, CZ);
+        const VectorRegister4Float DistSquared = VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX)));
+
+        const uint32 HitLanes = static_cast<uint32>(VectorMaskBits(VectorCompareLE(DistSquared, RadiusSquared))) & LaneMask;
+        if (!HitLanes) continue;
+
+        VectorStoreAligned(DistSquared, DistancesSquared);
+        VectorStoreAligned(CX, ClosestX);
+        VectorStoreAligned(CY, ClosestY);
+        VectorStoreAligned(CZ, ClosestZ);
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            if ((HitLanes & (1u << Lane)) && DistancesSquared[Lane] < BestDistanceSquared)
+            {
+                BestDistanceSquared = DistancesSquared[Lane];
+                BestLocalPoint = FVector3f(ClosestX[Lane], ClosestY[Lane], ClosestZ[Lane]);
+                HitSlot = First + Lane;
+            }
+        }
+    }
+
+    if (HitSlot != INDEX_NONE)
+    {
+        const FQuat4f Rotation(Boxes.QuatX[HitSlot], Boxes.QuatY[HitSlot], Boxes.QuatZ[HitSlot], Boxes.QuatW[HitSlot]);
+        const FVector3f BoxCenter(Boxes.CenterX[HitSlot], Boxes.CenterY[HitSlot], Boxes.CenterZ[HitSlot]);
+        OutClosestPoint = Boxes.Origin + FVector(BoxCenter + Rotation.RotateVector(BestLocalPoint));
+    }
+    return HitSlot;
+}
+
+FRewindShotHit BlasterRewindMath::SweepCandidates(TArrayView<const FRewindBoxes> Candidates, const FRewindSegment& Segment, float Radius)
+{
+    FRewindShotHit ShotHit;
+    float BestFraction = UE_MAX_FLT;
+    for (int32 Index = 0; Index < Candidates.Num(); ++Index)
+    {
+        float HitFraction = 1.f;
+        const int32 Slot = SweepBoxes(Candidates[Index], Segment.Start, Segment.End, Radius, HitFraction);
+        if (Slot != INDEX_NONE && HitFraction < BestFraction)
+        {
+            BestFraction = HitFraction;
+            ShotHit.CandidateIndex = Index;
+            ShotHit.Slot = Slot;
+        }
+    }
+
+    if (ShotHit.Slot != INDEX_NONE)
+    {
+        ShotHit.ImpactPoint = Segment.Start + (Segment.End - Segment.Start) * BestFraction;
+    }
+    return ShotHit;
+}
+
+void BlasterRewindMath::SolveJob(FRewindJob& Job)
+{
+    // Shows up in Insights on the worker that solved the job
+    TRACE_CPUPROFILER_EVENT_SCOPE(BlasterRewindMath::SolveJob);
+
+    if (Job.bSegmentsArePath)
+    {
+        // The first box hit along the path stops the projectile
+        FRewindShotHit& PathHit = Job.ShotHits.AddDefaulted_GetRef();
+        for (const FRewindSegment& Segment : Job.Segments)
+        {
+            PathHit = SweepCandidates(Job.Candidates, Segment, Job.SweepRadius);
+            if (PathHit.Slot != INDEX_NONE) break;
+        }
+    }
+    else
+    {
+        Job.ShotHits.Reserve(Job.Segments.Num());
+        for (const FRewindSegment& Segment : Job.Segments)
+        {
+            Job.ShotHits.Add(SweepCandidates(Job.Candidates, Segment, Job.SweepRadius));
+        }
+    }
+
+    if (Job.OverlapRadius <= 0.f) return;
+
+    if (!Job.ShotHits.IsEmpty() && Job.ShotHits[0].Slot != INDEX_NONE)
+    {
+        Job.bExploded = true;
+        Job.ExplosionOrigin = Job.ShotHits[0].ImpactPoint;
+    }
+    else if (Job.bPathHitWorld)
+    {
+        Job.bExploded = true;
+        Job.ExplosionOrigin = Job.PathWorldHit;
+    }
+    if (!Job.bExploded) return;
+
+    Job.Overlaps.SetNum(Job.Candidates.Num());
+    for (int32 Index = 0; Index < Job.Candidates.Num(); ++Index)
+    {
+        FRewindOverlap& Overlap = Job.Overlaps[Index];
+        Overlap.Slot = OverlapBoxes(Job.Candidates[Index], Job.ExplosionOrigin, Job.OverlapRadius, Overlap.ClosestPoint);
+    }
+}
+
+FBox BlasterRewindMath::ComputeBounds(const FFramePackage& Package)
+{
+    FBox Bounds(ForceInit);
+    if (!Package.Character) return Bounds;
+
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        if (!Package.Character->HasHitBox(Slot)) continue;
+
+        // Half size of the rotated box along the world axes
+        const FQuat& Rotation = Package.Rotations[Slot];
+        const FVector& Extent = Package.BoxExtents[Slot];
+        const FVector WorldExtent = Rotation.GetAxisX().GetAbs() * Extent.X +  //
+                                    Rotation.GetAxisY().GetAbs() * Extent.Y +  //
+                                    Rotation.GetAxisZ().GetAbs() * Extent.Z;
+        Bounds += FBox(Package.Locations[Slot] - WorldExtent, Package.Locations[Slot] + WorldExtent);
+    }
+    return Bounds;
+}
+
+bool BlasterRewindMath::SegmentsTouchBounds(TArrayView<const FRewindSegment> Segments, const FBox& Bounds, float Radius)
+{
+    if (!Bounds.IsValid) return false;
+
+    const FBox ReachBounds = Bounds.ExpandBy(Radius);
+    for (const FRewindSegment& Segment : Segments)
+    {
+        if (FMath::LineBoxIntersection(ReachBounds, Segment.Start, Segment.End, Segment.End - Segment.Start)) return true;
+    }
+    return false;
+}
@@ -38,7 +38,12 @@
 #include "BlasterAnimInstance.h"
 #include "Weapon.h"
 #include "CarryItem.h"
+#include "HitBoxTypes.h"
+#include "HitBoxSet.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Blaster.h"
+#include "FXPoolSubsystem.h"
+#include "DamageQueueSubsystem.h"
 #include "BlasterCharacter.h"
 
 ABlasterCharacter::ABlasterCharacter()
@@ -91,100 +96,70 @@ ABlasterCharacter::ABlasterCharacter()
     AttachedGrenade->SetupAttachment(GetMesh(), FName("GrenadeSocket"));
     AttachedGrenade->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 
-    SetUpHitShapesSSR();
-}
+    /** Legacy hit boxes, only their settings are read */
 
-void ABlasterCharacter::SetUpHitShapesSSR()
-{
-    /**
-     * Hit boxes for server - side rewind
-     */
     head = CreateDefaultSubobject<UBoxComponent>("head");
     head->SetupAttachment(GetMesh(), "head");
-    HitCollisionBoxes.Add("head", head);
 
     pelvis = CreateDefaultSubobject<UBoxComponent>("pelvis");
     pelvis->SetupAttachment(GetMesh(), "pelvis");
-    HitCollisionBoxes.Add("pelvis", pelvis);
 
     spine_02 = CreateDefaultSubobject<UBoxComponent>("spine_02");
     spine_02->SetupAttachment(GetMesh(), "spine_02");
-    HitCollisionBoxes.Add("spine_02", spine_02);
 
     spine_03 = CreateDefaultSubobject<UBoxComponent>("spine_03");
     spine_03->SetupAttachment(GetMesh(), "spine_03");
-    HitCollisionBoxes.Add("spine_03", spine_03);
 
     upperarm_l = CreateDefaultSubobject<UBoxComponent>("upperarm_l");
     upperarm_l->SetupAttachment(GetMesh(), "upperarm_l");
-    HitCollisionBoxes.Add("upperarm_l", upperarm_l);
 
     upperarm_r = CreateDefaultSubobject<UBoxComponent>("upperarm_r");
     upperarm_r->SetupAttachment(GetMesh(), "upperarm_r");
-    HitCollisionBoxes.Add("upperarm_r", upperarm_r);
 
     lowerarm_l = CreateDefaultSubobject<UBoxComponent>("lowerarm_l");
     lowerarm_l->SetupAttachment(GetMesh(), "lowerarm_l");
-    HitCollisionBoxes.Add("lowerarm_l", lowerarm_l);
 
     lowerarm_r = CreateDefaultSubobject<UBoxComponent>("lowerarm_r");
     lowerarm_r->SetupAttachment(GetMesh(), "lowerarm_r");
-    HitCollisionBoxes.Add("lowerarm_r", lowerarm_r);
 
     hand_l = CreateDefaultSubobject<UBoxComponent>("hand_l");
     hand_l->SetupAttachment(GetMesh(), "hand_l");
-    HitCollisionBoxes.Add("hand_l", hand_l);
 
     hand_r = CreateDefaultSubobject<UBoxComponent>("hand_r");
     hand_r->SetupAttachment(GetMesh(), "hand_r");
-    HitCollisionBoxes.Add("hand_r", hand_r);
 
     backpack = CreateDefaultSubobject<UBoxComponent>("backpack");
     backpack->SetupAttachment(GetMesh(), "backpack");
-    HitCollisionBoxes.Add("backpack", backpack);
 
     blanket_l = CreateDefaultSubobject<UBoxComponent>("blanket_l");
     blanket_l->SetupAttachment(GetMesh(), "blanket_l");
-    HitCollisionBoxes.Add("blanket_l", blanket_l);
 
     blanket_r = CreateDefaultSubobject<UBoxComponent>("blanket_r");
     blanket_r->SetupAttachment(GetMesh(), "blanket_r");
-    HitCollisionBoxes.Add("blanket_r", blanket_r);
 
     thigh_l = CreateDefaultSubobject<UBoxComponent>("thigh_l");
     thigh_l->SetupAttachment(GetMesh(), "thigh_l");
-    HitCollisionBoxes.Add("thigh_l", thigh_l);
 
     thigh_r = CreateDefaultSubobject<UBoxComponent>("thigh_r");
     thigh_r->SetupAttachment(GetMesh(), "thigh_r");
-    HitCollisionBoxes.Add("thigh_r", thigh_r);
 
     calf_l = CreateDefaultSubobject<UBoxComponent>("calf_l");
     calf_l->SetupAttachment(GetMesh(), "calf_l");
-    HitCollisionBoxes.Add("calf_l", calf_l);
 
     calf_r = CreateDefaultSubobject<UBoxComponent>("calf_r");
     calf_r->SetupAttachment(GetMesh(), "calf_r");
-    HitCollisionBoxes.Add("calf_r", calf_r);
 
     foot_l = CreateDefaultSubobject<UBoxComponent>("foot_l");
     foot_l->SetupAttachment(GetMesh(), "foot_l");
-    HitCollisionBoxes.Add("foot_l", foot_l);
 
     foot_r = CreateDefaultSubobject<UBoxComponent>("foot_r");
     foot_r->SetupAttachment(GetMesh(), "foot_r");
-    HitCollisionBoxes.Add("foot_r", foot_r);
 
-    for (auto& Box : HitCollisionBoxes)
+    for (UBoxComponent* Box : {head, pelvis, spine_02, spine_03, upperarm_l, upperarm_r, lowerarm_l, lowerarm_r, hand_l, hand_r,
+             backpack, blanket_l, blanket_r, thigh_l, thigh_r, calf_l, calf_r, foot_l, foot_r})
     {
-        if (Box.Value)
-        {
-            Box.Value->SetCollisionObjectType(ECC_HitBox);
-            Box.Value->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
-            Box.Value->SetCollisionResponseToChannel(ECC_HitBox, ECollisionResponse::ECR_Block);
-            Box.Value->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-            Box.Value->bReturnMaterialOnMove = true;
-        }
+        Box->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        Box->bAutoRegister = false;
     }
 }
 
@@ -244,6 +219,11 @@ void ABlasterCharacter::BeginPlay()
         AttachedGrenade->SetVisibility(false);
     }
 
+    if (UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr)
+    {
+        FXPool->Prewarm(ElimBotEffect, 1);
+    }
+
     if (IsControllerValid())
     {
         BlasterPlayerController->OnPlayerCharacterBeginPlay.Broadcast();
@@ -350,6 +330,8 @@ void ABlasterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 void ABlasterCharacter::PostInitializeComponents()
 {
     Super::PostInitializeComponents();
+    CacheHitBoxBones();
+
     if (CombatComp)
     {
         CombatComp->BlasterCharacter = this;
@@ -512,10 +494,10 @@ void ABlasterCharacter::PlayFireMontage(bool bAiming)
     PlayMontage(FireWeaponMontage, SectionName);
 }
 
-void ABlasterCharacter::PlayHitReactMontage(AActor* DamageCauser)
+void ABlasterCharacter::PlayHitReactMontage(const FVector& DamageCauserLocation)
 {
-    if (!IsWeaponEquipped() || !DamageCauser) return;
-    double Theta = GetDirectionalHitReactAngle(DamageCauser->GetActorLocation());
+    if (!IsWeaponEquipped()) return;
+    double Theta = GetDirectionalHitReactAngle(DamageCauserLocation);
     FName SectionName = GetDirectionalHitReactSection(Theta);
     PlayMontage(HitReactMontage, SectionName);
 }
@@ -565,40 +547,64 @@ void ABlasterCharacter::StopAllMontages()
 void ABlasterCharacter::ReceiveDamage(
     AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
 {
-    if (bElimmed || !IsBlasterGameModeValid()) return;
-    Damage = BlasterGameMode->CalculateDamage(InstigatedBy, GetController(), Damage);
+    if (bElimmed) return;
+
+    if (UDamageQueueSubsystem* DamageQueue = GetWorld() ? GetWorld()->GetSubsystem<UDamageQueueSubsystem>() : nullptr)
+    {
+        DamageQueue->QueueDamage(this, Damage, InstigatedBy, DamageCauser);
+        return;
+    }
+
+    FQueuedDamage Attacker;
+    Attacker.InstigatedBy = InstigatedBy;
+    Attacker.DamageCauser = DamageCauser;
+    Attacker.Damage = Damage;
+    ApplyFrameDamage(MakeArrayView(&Attacker, 1));
+}
+
+void ABlasterCharacter::ApplyFrameDamage(TArrayView<const FQueuedDamage> Attackers)
+{
+    if (bElimmed || Attackers.IsEmpty() || !IsBlasterGameModeValid()) return;
 
-    float DamageToHealth = Damage;
-    if (Shield > 0.f)
+    // Attackers are applied in the order they first hit, the one whose damage takes health to zero gets the
+    // elimination. The reaction faces the biggest hit
+    float BiggestDamage = -1.f;
+    AController* InstigatedBy = Attackers.Last().InstigatedBy;
+    bool bKilled = false;
+    AActor* DamageCauser = nullptr;
+    for (const FQueuedDamage& Attacker : Attackers)
     {
-        if (Shield >= Damage)
+        const float AttackerDamage = BlasterGameMode->CalculateDamage(Attacker.InstigatedBy, GetController(), Attacker.Damage);
+        if (AttackerDamage > BiggestDamage && Attacker.DamageCauser)
         {
-            Shield = FMath::Clamp(Shield - Damage, 0.f, MaxShield);
-            DamageToHealth = 0.f;
+            BiggestDamage = AttackerDamage;
+            DamageCauser = Attacker.DamageCauser;
         }
-        else
+
+        const float DamageToShield = FMath::Clamp(AttackerDamage, 0.f, Shield);
+        Shield = FMath::Clamp(Shield - DamageToShield, 0.f, MaxShield);
+        Health = FMath::Clamp(Health - (AttackerDamage - DamageToShield), 0.f, MaxHealth);
+        if (!bKilled && FMath::IsNearlyZero(Health))
         {
-            DamageToHealth = FMath::Clamp(DamageToHealth - Shield, 0.f, Damage);
-            Shield = 0.f;
+            bKilled = true;
+            InstigatedBy = Attacker.InstigatedBy;
         }
     }
 
-    Health = FMath::Clamp(Health - DamageToHealth, 0.f, MaxHealth);
-
     UpdateHUDHealth();
     UpdateHUDShield();
-    if (CombatComp && CombatComp->CombatState == ECombatState::ECS_Unoccupied)
+    if (CombatComp && CombatComp->CombatState == ECombatState::ECS_Unoccupied && DamageCauser)
     {
-        MulticastHitReactMontage(DamageCauser);
+        MulticastHitReactMontage(DamageCauser->GetActorLocation());
     }
 
     if (!GetMesh()->GetAnimInstance()) return;
     CheckIfEliminated(InstigatedBy);
 }
 
-void ABlasterCharacter::MulticastHitReactMontage_Implementation(AActor* DamageCauser)
+void ABlasterCharacter::MulticastHitReactMontage_Implementation(const FVector_NetQuantize& DamageCauserLocation)
 {
-    PlayHitReactMontage(DamageCauser);
+    PlayHitReactMontage(DamageCauserLocation);
 }
 
 void ABlasterCharacter::OnRep_ReplicatedMovement()
@@ -711,10 +717,14 @@ void ABlasterCharacter::MulticastElim_Implementation(bool bPlayerLeftGame)
     }
 
     // Spawn Elim bot
-    if (ElimBotEffect && ElimBotSound)
+    UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr;
+    if (ElimBotEffect && ElimBotSound && FXPool)
     {
         FVector ElimBotSpawnPoint(GetActorLocation().X, GetActorLocation().Y, GetActorLocation().Z + 200.f);
-        ElimBotComponent = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ElimBotEffect, ElimBotSpawnPoint, GetActorRotation());
+        ElimBotComponent = FXPool->SpawnEmitterAtLocation(      //
+            ElimBotEffect,                                      //
+            FTransform(GetActorRotation(), ElimBotSpawnPoint),  //
+            EFXPoolMethod::ManualRelease);
 
         UGameplayStatics::SpawnSoundAtLocation(this, ElimBotSound, GetActorLocation());
     }
@@ -730,9 +740,10 @@ void ABlasterCharacter::MulticastElim_Implementation(bool bPlayerLeftGame)
         GetWorldTimerManager().ClearTimer(BuffComp->InvisibilityBuffTimer);
     }
 
-    if (PickupEffect)
+    if (PickupEffect && FXPool)
     {
-        PickupEffect->DeactivateImmediate();
+        FXPool->ReleaseFX(PickupEffect);
+        PickupEffect = nullptr;
     }
 
     if (CrownComponent)
@@ -823,10 +834,14 @@ void ABlasterCharacter::Destroyed()
 {
     Super::Destroyed();
 
-    if (ElimBotComponent)
+    UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr;
+    if (FXPool)
     {
-        ElimBotComponent->DestroyComponent();
+        FXPool->ReleaseFX(ElimBotComponent);
+        FXPool->ReleaseFX(PickupEffect);
     }
+    ElimBotComponent = nullptr;
+    PickupEffect = nullptr;
 
     bool bMatchNotInProgress = IsBlasterGameModeValid() && BlasterGameMode->GetMatchState() != MatchState::InProgress;
     if (IsWeaponEquipped() && bMatchNotInProgress)
@@ -1047,6 +1062,111 @@ bool ABlasterCharacter::IsCharacterGainedTheLead()
     return false;
 }
 
+bool ABlasterCharacter::GetHitBoxDamageModifier(int32 Slot, float& OutDamageModifier) const
+{
+    if (!HasHitBox(Slot)) return false;
+    return GetDamageModifier(GetHitBoxSet()->HitBoxes[Slot].PhysMaterial, OutDamageModifier);
+}
+
+void ABlasterCharacter::CacheHitBoxBones()
+{
+    HitBoxBoneIndices.Init(INDEX_NONE, HitBox::Num);
+    if (!GetMesh()) return;
+
+    if (!HitBoxSet)
+    {
+        MigrateLegacyHitBoxes();
+    }
+
+    const UHitBoxSet* Set = GetHitBoxSet();
+    for (int32 Slot = 0; Slot < HitBox::Num && Set->HitBoxes.IsValidIndex(Slot); ++Slot)
+    {
+        HitBoxBoneIndices[Slot] = GetMesh()->GetBoneIndex(Set->HitBoxes[Slot].BoneName);
+    }
+}
+
+void ABlasterCharacter::MigrateLegacyHitBoxes()
+{
+    // Logged once, every character of a class without a set migrates the same way
+    static bool bLoggedMigration = false;
+    UE_CLOG(!bLoggedMigration, LogBlaster, Log, TEXT("%s has no HitBoxSet, its hit boxes are migrated from its box components"),
+        *GetClass()->GetName());
+    bLoggedMigration = true;
+
+    const UBoxComponent* const LegacyBoxes[HitBox::Num] = {head, pelvis, spine_02, spine_03, upperarm_l, upperarm_r, lowerarm_l,
+        lowerarm_r, hand_l, hand_r, backpack, blanket_l, blanket_r, thigh_l, thigh_r, calf_l, calf_r, foot_l, foot_r};
+
+    MigratedHitBoxSet = NewObject<UHitBoxSet>(this, NAME_None, RF_Transient);
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        const UBoxComponent* Box = LegacyBoxes[Slot];
+        if (!Box) continue;
+
+        // The same pose the attached box had: relative to its socket, the extent unscaled, the body's material
+        FHitBoxDefinition& Definition = MigratedHitBoxSet->HitBoxes[Slot];
+        Definition.BoneName = Box->GetAttachSocketName();
+        Definition.LocalOffset = Box->GetRelativeLocation();
+        Definition.LocalRotation = Box->GetRelativeRotation();
+        Definition.Extent = Box->GetUnscaledBoxExtent();
+        Definition.PhysMaterial = Box->BodyInstance.GetSimplePhysicalMaterial();
+    }
+}
+
+const UHitBoxSet* ABlasterCharacter::GetHitBoxSet() const
+{
+    if (HitBoxSet) return HitBoxSet;
+    return MigratedHitBoxSet ? MigratedHitBoxSet : GetDefault<UHitBoxSet>();
+}
+
+bool ABlasterCharacter::HasHitBox(int32 Slot) const
+{
+    return HitBoxBoneIndices.IsValidIndex(Slot) && HitBoxBoneIndices[Slot] != INDEX_NONE;
+}
+
+FVector ABlasterCharacter::GetHitBoxExtent(int32 Slot) const
+{
+    return HasHitBox(Slot) ? GetHitBoxSet()->HitBoxes[Slot].Extent : FVector::ZeroVector;
+}
+
+FName ABlasterCharacter::GetHitBoxBoneName(int32 Slot) const
+{
+    return HasHitBox(Slot) ? GetHitBoxSet()->HitBoxes[Slot].BoneName : NAME_None;
+}
+
+void ABlasterCharacter::CaptureHitBoxes(FFramePackage& OutPackage) const
+{
+    const UHitBoxSet* Set = GetHitBoxSet();
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        if (!HasHitBox(Slot))
+        {
+            // Missing boxes are never tested, only keep them encodable
+            OutPackage.Locations[Slot] = FVector::ZeroVector;
+            OutPackage.Rotations[Slot] = FQuat::Identity;
+            OutPackage.BoxExtents[Slot] = FVector::ZeroVector;
+            continue;
+        }
+
+        // Same as a box attached to the bone: the offset follows the bone scale, the extent doesn't
+        const FHitBoxDefinition& Definition = Set->HitBoxes[Slot];
+        const FTransform BoxTransform =
+            FTransform(Definition.LocalRotation, Definition.LocalOffset) * GetMesh()->GetBoneTransform(HitBoxBoneIndices[Slot]);
+        OutPackage.Locations[Slot] = BoxTransform.GetLocation();
+        OutPackage.Rotations[Slot] = BoxTransform.GetRotation();
+        OutPackage.BoxExtents[Slot] = Definition.Extent;
+    }
+}
+
+bool ABlasterCharacter::GetDamageModifier(UPhysicalMaterial* PhysMat, float& OutDamageModifier) const
+{
+    if (const float* DamageModifier = DamageModifiers.Find(PhysMat))
+    {
+        OutDamageModifier = *DamageModifier;
+        return true;
+    }
+    return false;
+}
+
 void ABlasterCharacter::OnRep_OverlappingCarryItem(ACarryItem* LastCarryItem)
 {
     if (OverlappingCarryItem)
@@ -0,0 +1,13 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitBoxTypes.h"
+#include "HitBoxSet.h"
+
+UHitBoxSet::UHitBoxSet()
+{
+    HitBoxes.SetNum(HitBox::Num);
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        HitBoxes[Slot].BoneName = HitBox::GetDefaultBoneName(Slot);
+    }
+}
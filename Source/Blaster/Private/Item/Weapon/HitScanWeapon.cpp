@@ -12,12 +12,23 @@
 #include "Particles/ParticleSystemComponent.h"
 #include "Sound/SoundBase.h"
 #include "DrawDebugHelpers.h"
-#include "Components/DecalComponent.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "CarryItemTypes.h"
 #include "LagCompensationComponent.h"
+#include "FXPoolSubsystem.h"
 #include "HitScanWeapon.h"
 
+void AHitScanWeapon::BeginPlay()
+{
+    Super::BeginPlay();
+
+    if (UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr)
+    {
+        FXPool->Prewarm(BeamParticles);
+        FXPool->Prewarm(MuzzleFlash);
+    }
+}
+
 void AHitScanWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation)
 {
     Super::Fire(HitTarget, SocketLocation);
@@ -38,16 +49,15 @@ void AHitScanWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector
                 {
                     bool bCauseAuthDamage = !bUseServerSideRewind || OwnerPawn->IsLocallyControlled();
                     // Apply Damage on server
+                    float DamageModifier = 1.f;
                     if (HasAuthority() && bCauseAuthDamage && FireHit.PhysMaterial.IsValid())
                     {
-
-                        UPhysicalMaterial* PhysMat = FireHit.PhysMaterial.Get();
-                        if (HitCharacter->DamageModifiers.Contains(PhysMat))
+                        if (HitCharacter->GetDamageModifier(FireHit.PhysMaterial.Get(), DamageModifier))
                         {
-                            UGameplayStatics::ApplyDamage(HitCharacter,           //
-                                Damage * HitCharacter->DamageModifiers[PhysMat],  //                                      //
-                                InstigatorController,                             //
-                                this,                                             //
+                            UGameplayStatics::ApplyDamage(HitCharacter,  //
+                                Damage * DamageModifier,                 //
+                                InstigatorController,                    //
+                                this,                                    //
                                 UDamageType::StaticClass());
                         }
                     }
@@ -59,17 +69,18 @@ void AHitScanWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector
                              BlasterOwnerCharacter->GetLagCompensationComponent())  //
                     {
 
-                        float HitTime = BlasterOwnerController->GetServerTime() - BlasterOwnerController->SingleTripTime;
+                        float HitTime =
+                            BlasterOwnerController->GetServerTime() - BlasterOwnerController->SingleTripTime - ShotTimeOffset;
 
                         // Hacked, check validation
                         // Damage = 10000;
 
-                        BlasterOwnerCharacter->GetLagCompensationComponent()->ServerScoreRequest(  //
-                            HitCharacter,                                                          //
-                            SocketLocation,                                                        //
-                            HitTarget,                                                             //
-                            HitTime,                                                               //
-                            Damage,                                                                //
+                        BlasterOwnerCharacter->GetLagCompensationComponent()->ScoreRequest(  //
+                            HitCharacter,                                                    //
+                            SocketLocation,                                                  //
+                            HitTarget,                                                       //
+                            HitTime,                                                         //
+                            Damage,                                                          //
                             this);
                     }
                 }
@@ -77,9 +88,10 @@ void AHitScanWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector
             SpawnImpactFXAndSound(FireHit);
         }
 
-        if (MuzzleFlash)
+        UFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UFXPoolSubsystem>();
+        if (MuzzleFlash && FXPool)
         {
-            UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), MuzzleFlash, GetLocalWeaponSocketTransform());
+            FXPool->SpawnEmitterAtLocation(MuzzleFlash, GetLocalWeaponSocketTransform());
         }
         if (FireSound)
         {
@@ -103,10 +115,10 @@ void AHitScanWeapon::WeaponTraceHit(const FVector& TraceStart, const FVector_Net
         BeamEnd = OutHit.ImpactPoint;
     }
 
-    if (BeamParticles)
+    UFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UFXPoolSubsystem>();
+    if (BeamParticles && FXPool)
     {
-        if (UParticleSystemComponent* Beam =
-                UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BeamParticles, GetLocalWeaponSocketTransform(), true))
+        if (UParticleSystemComponent* Beam = FXPool->SpawnEmitterAtLocation(BeamParticles, GetLocalWeaponSocketTransform()))
         {
             Beam->SetVectorParameter("Target", BeamEnd);
         }
@@ -115,63 +127,22 @@ void AHitScanWeapon::WeaponTraceHit(const FVector& TraceStart, const FVector_Net
 
 void AHitScanWeapon::SpawnImpactFXAndSound(FHitResult& FireHit)
 {
-
-    FImpactData ImpactData = GetImpactData(FireHit);
-
-    SpawnImpactParticles(FireHit, ImpactData);
-    SpawnImpactSound(FireHit, ImpactData);
-    SpawnImpactDecal(FireHit, ImpactData);
-}
-
-void AHitScanWeapon::SpawnImpactParticles(FHitResult& FireHit, FImpactData& ImpactData)
-{
-    if (ImpactData.ImpactParticles && GetWorld())
-    {
-        UGameplayStatics::SpawnEmitterAtLocation(
-            GetWorld(), ImpactData.ImpactParticles, FireHit.ImpactPoint, FireHit.ImpactNormal.Rotation());
-    }
-}
-
-void AHitScanWeapon::SpawnImpactSound(FHitResult& FireHit, FImpactData& ImpactData)
-{
-    if (ImpactData.ImpactSound)
+    UImpactSubsystem* ImpactSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UImpactSubsystem>() : nullptr;
+    if (ImpactSubsystem && ImpactSubsystem->WantsImpacts())
     {
-        UGameplayStatics::PlaySoundAtLocation(this, ImpactData.ImpactSound, FireHit.ImpactPoint);
+        ImpactSubsystem->QueueImpact(MakeImpactEvent(FireHit));
     }
 }
 
-void AHitScanWeapon::SpawnImpactDecal(FHitResult& FireHit, FImpactData& ImpactData)
+FImpactEvent AHitScanWeapon::MakeImpactEvent(const FHitResult& FireHit)
 {
-    if (ImpactData.DecalData.Material && GetWorld())
-    {
-        UDecalComponent* DecalComponent = UGameplayStatics::SpawnDecalAtLocation(GetWorld(),  //
-            ImpactData.DecalData.Material,                                                    //
-            ImpactData.DecalData.Size,                                                        //
-            FireHit.ImpactPoint,                                                              //
-            FireHit.ImpactNormal.Rotation());
-
-        if (DecalComponent)
-        {
-            DecalComponent->SetFadeScreenSize(0.f);
-            DecalComponent->SetFadeOut(ImpactData.DecalData.LifeTime, ImpactData.DecalData.FadeOutTime);
-        }
-    }
+    return FImpactEvent::Make(GetImpactData(FireHit), FireHit);
 }
 
-FImpactData AHitScanWeapon::GetImpactData(FHitResult& FireHit)
+const FImpactData& AHitScanWeapon::GetImpactData(const FHitResult& FireHit) const
 {
-    FImpactData ImpactData = DefaultImpactData;
-
-    if (FireHit.PhysMaterial.IsValid())
-    {
-        UPhysicalMaterial* PhysMat = FireHit.PhysMaterial.Get();
-        if (ImpactDataMap.Contains(PhysMat))
-        {
-            ImpactData = ImpactDataMap[PhysMat];
-        }
-    }
-
-    return ImpactData;
+    const FImpactData* ImpactData = ImpactDataMap.Find(FireHit.PhysMaterial.Get());
+    return ImpactData ? *ImpactData : DefaultImpactData;
 }
 
 FTransform AHitScanWeapon::GetLocalWeaponSocketTransform()
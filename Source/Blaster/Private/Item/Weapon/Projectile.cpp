@@ -3,7 +3,8 @@
 #include "GameFramework/Pawn.h"
 #include "GameFramework/DamageType.h"
 #include "Components/BoxComponent.h"
-#include "Components/DecalComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "GameFramework/ProjectileMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
 #include "NiagaraFunctionLibrary.h"
 #include "NiagaraComponent.h"
@@ -19,6 +20,7 @@
 #include "Weapon.h"
 #include "BlasterPlayerController.h"
 #include "Blaster.h"
+#include "ProjectilePoolSubsystem.h"
 #include "Projectile.h"
 
 AProjectile::AProjectile()
@@ -42,16 +44,96 @@ void AProjectile::BeginPlay()
 {
     Super::BeginPlay();
 
-    if (Tracer)
+    CollisionBox->OnComponentHit.AddDynamic(this, &ThisClass::OnHit);
+    CollisionBox->bReturnMaterialOnMove = true;
+
+    if (bStartDeactivated)
+    {
+        DeactivateProjectile();
+    }
+    else
+    {
+        ActivateProjectile();
+    }
+}
+
+void AProjectile::ActivateProjectile()
+{
+    SetActorHiddenInGame(false);
+    if (ProjectileMesh)
+    {
+        ProjectileMesh->SetVisibility(true);
+    }
+    CollisionBox->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+    if (GetOwner())
+    {
+        CollisionBox->IgnoreActorWhenMoving(GetOwner(), true);
+    }
+
+    if (UProjectileMovementComponent* MovementComponent = GetProjectileMovement())
+    {
+        // A hit stops the simulation and drops the updated component
+        MovementComponent->SetUpdatedComponent(CollisionBox);
+        MovementComponent->Velocity = GetActorForwardVector() * MovementComponent->InitialSpeed;
+        MovementComponent->UpdateComponentVelocity();
+        MovementComponent->SetComponentTickEnabled(true);
+    }
+
+    if (TracerComponent)
+    {
+        TracerComponent->Activate(true);
+    }
+    else if (Tracer)
     {
         TracerComponent = UGameplayStatics::SpawnEmitterAttached(
-            Tracer, CollisionBox, FName(), GetActorLocation(), GetActorRotation(), EAttachLocation::KeepWorldPosition);
+            Tracer, CollisionBox, FName(), GetActorLocation(), GetActorRotation(), EAttachLocation::KeepWorldPosition, false);
     }
 
-    CollisionBox->OnComponentHit.AddDynamic(this, &ThisClass::OnHit);
-    CollisionBox->IgnoreActorWhenMoving(Owner, true);
-    CollisionBox->bReturnMaterialOnMove = true;
-    SetLifeSpan(LifeSpan);
+    GetWorldTimerManager().SetTimer(LifeSpanTimer, this, &ThisClass::DestroyProjectile, LifeSpan, false);
+}
+
+void AProjectile::DeactivateProjectile()
+{
+    GetWorldTimerManager().ClearTimer(DestroyTimer);
+    GetWorldTimerManager().ClearTimer(LifeSpanTimer);
+
+    if (UProjectileMovementComponent* MovementComponent = GetProjectileMovement())
+    {
+        MovementComponent->StopMovementImmediately();
+        MovementComponent->SetComponentTickEnabled(false);
+    }
+    CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    CollisionBox->ClearMoveIgnoreActors();
+
+    if (TracerComponent)
+    {
+        TracerComponent->DeactivateImmediate();
+    }
+    if (TrailSystemComponent)
+    {
+        TrailSystemComponent->DeactivateImmediate();
+    }
+    SetActorHiddenInGame(true);
+}
+
+void AProjectile::ResetProjectile()
+{
+    bUseServerSideRewind = false;
+    TraceStart = FVector_NetQuantize();
+    InitialVelocity = FVector_NetQuantize100();
+    OwningWeapon = nullptr;
+    SetOwner(nullptr);
+    SetInstigator(nullptr);
+}
+
+void AProjectile::DestroyProjectile()
+{
+    if (UProjectilePoolSubsystem* ProjectilePool = GetWorld() ? GetWorld()->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+    {
+        ProjectilePool->ReleaseProjectile(this);
+        return;
+    }
+    Destroy();
 }
 
 void AProjectile::Tick(float DeltaTime)
@@ -63,12 +145,16 @@ void AProjectile::OnHit(
     UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
     SpawnImpactFXAndSound(Hit);
-    Destroy();
+    DestroyProjectile();
 }
 
 void AProjectile::SpawnTrailSystem()
 {
-    if (TrailSystem)
+    if (TrailSystemComponent)
+    {
+        TrailSystemComponent->Activate(true);
+    }
+    else if (TrailSystem)
     {
         TrailSystemComponent = UNiagaraFunctionLibrary::SpawnSystemAttached(  //
             TrailSystem,                                                      //
@@ -110,16 +196,16 @@ void AProjectile::ExplodeDamage(const FVector& ImpactPoint)
 
                 ABlasterPlayerController* OwnerController = Cast<ABlasterPlayerController>(OwnerCharacter->GetController());
                 float HitTime = OwnerController->GetServerTime() - OwnerController->SingleTripTime;
-                OwnerCharacter->GetLagCompensationComponent()->ExplosionProjectileServerScoreRequest(  //
-                    HitCharacters,                                                                     //
-                    TraceStart,                                                                        //
-                    InitialVelocity,                                                                   //
-                    GravityScale,                                                                      //
-                    Damage,                                                                            //
-                    DamageInnerRadius,                                                                 //
-                    DamageOuterRadius,                                                                 //
-                    OwningWeapon,                                                                      //
-                    HitTime                                                                            //
+                OwnerCharacter->GetLagCompensationComponent()->ExplosionProjectileScoreRequest(  //
+                    HitCharacters,                                                               //
+                    TraceStart,                                                                  //
+                    InitialVelocity,                                                             //
+                    GravityScale,                                                                //
+                    Damage,                                                                      //
+                    DamageInnerRadius,                                                           //
+                    DamageOuterRadius,                                                           //
+                    OwningWeapon,                                                                //
+                    HitTime                                                                      //
                 );
             }
         }
@@ -133,63 +219,30 @@ void AProjectile::StartDestoryTimer()
 
 void AProjectile::DestroyTimerFinished()
 {
-    Destroy();
+    DestroyProjectile();
 }
 
 void AProjectile::SpawnImpactFXAndSound(const FHitResult& FireHit)
 {
-    FImpactData ImpactData = GetImpactData(FireHit);
-    SpawnImpactParticles(FireHit, ImpactData);
-    SpawnImpactSound(FireHit, ImpactData);
-    SpawnImpactDecal(FireHit, ImpactData);
-}
-
-void AProjectile::SpawnImpactParticles(const FHitResult& FireHit, FImpactData& ImpactData)
-{
-    if (ImpactData.ImpactParticles && GetWorld())
+    UImpactSubsystem* ImpactSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UImpactSubsystem>() : nullptr;
+    if (ImpactSubsystem && ImpactSubsystem->WantsImpacts())
     {
-        UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactData.ImpactParticles, GetActorLocation());
+        ImpactSubsystem->QueueImpact(MakeImpactEvent(FireHit));
     }
 }
 
-void AProjectile::SpawnImpactSound(const FHitResult& FireHit, FImpactData& ImpactData)
+FImpactEvent AProjectile::MakeImpactEvent(const FHitResult& FireHit)
 {
-    if (ImpactData.ImpactSound)
-    {
-        UGameplayStatics::PlaySoundAtLocation(this, ImpactData.ImpactSound, GetActorLocation());
-    }
-}
-
-void AProjectile::SpawnImpactDecal(const FHitResult& FireHit, FImpactData& ImpactData)
-{
-    if (FireHit.bBlockingHit && ImpactData.DecalData.Material && GetWorld())
-    {
-        UDecalComponent* DecalComponent = UGameplayStatics::SpawnDecalAtLocation(GetWorld(),  //
-            ImpactData.DecalData.Material,                                                    //
-            ImpactData.DecalData.Size,                                                        //
-            FireHit.ImpactPoint,                                                              //
-            FireHit.ImpactNormal.Rotation());
-
-        if (DecalComponent)
-        {
-            DecalComponent->SetFadeScreenSize(0.f);
-            DecalComponent->SetFadeOut(ImpactData.DecalData.LifeTime, ImpactData.DecalData.FadeOutTime);
-        }
-    }
+    // Particles and sound play where the projectile stopped, the decal needs a surface
+    FImpactEvent Impact = FImpactEvent::Make(GetImpactData(FireHit), FireHit);
+    Impact.EffectLocation = GetActorLocation();
+    Impact.EffectRotation = FRotator::ZeroRotator;
+    Impact.bSpawnDecal = FireHit.bBlockingHit;
+    return Impact;
 }
 
-FImpactData AProjectile::GetImpactData(const FHitResult& FireHit)
+const FImpactData& AProjectile::GetImpactData(const FHitResult& FireHit) const
 {
-    FImpactData ImpactData = DefaultImpactData;
-
-    if (FireHit.PhysMaterial.IsValid())
-    {
-        UPhysicalMaterial* PhysMat = FireHit.PhysMaterial.Get();
-        if (ImpactDataMap.Contains(PhysMat))
-        {
-            ImpactData = ImpactDataMap[PhysMat];
-        }
-    }
-
-    return ImpactData;
+    const FImpactData* ImpactData = ImpactDataMap.Find(FireHit.PhysMaterial.Get());
+    return ImpactData ? *ImpactData : DefaultImpactData;
 }
@@ -46,12 +46,12 @@ void AProjectileBullet::OnHit(
         {
             if (ABlasterCharacter* HitCharacter = Cast<ABlasterCharacter>(OtherActor))
             {
+                float DamageModifier = 1.f;
                 if (OwnerCharacter->HasAuthority() && !bUseServerSideRewind && Hit.PhysMaterial.IsValid())
                 {
-                    UPhysicalMaterial* PhysMat = Hit.PhysMaterial.Get();
-                    if (HitCharacter->DamageModifiers.Contains(PhysMat))
+                    if (HitCharacter->GetDamageModifier(Hit.PhysMaterial.Get(), DamageModifier))
                     {
-                        UGameplayStatics::ApplyDamage(OtherActor, Damage * HitCharacter->DamageModifiers[PhysMat], OwnerController, OwningWeapon, UDamageType::StaticClass());
+                        UGameplayStatics::ApplyDamage(OtherActor, Damage * DamageModifier, OwnerController, OwningWeapon, UDamageType::StaticClass());
                         Super::OnHit(HitComp, OtherActor, OtherComp, NormalImpulse, Hit);
                         return;
                     }
@@ -67,14 +67,14 @@ void AProjectileBullet::OnHit(
                         // InitialVelocity *= 100000;
 
                         float HitTime = OwnerController->GetServerTime() - OwnerController->SingleTripTime;
-                        OwnerCharacter->GetLagCompensationComponent()->ProjectileServerScoreRequest(  //
-                            HitCharacter,                                                             //
-                            TraceStart,                                                               //
-                            InitialVelocity,                                                          //
-                            GravityScale,                                                             //
-                            HitTime,                                                                  //
-                            Damage,                                                                   //
-                            OwningWeapon                                                              //
+                        OwnerCharacter->GetLagCompensationComponent()->ProjectileScoreRequest(  //
+                            HitCharacter,                                                       //
+                            TraceStart,                                                         //
+                            InitialVelocity,                                                    //
+                            GravityScale,                                                       //
+                            HitTime,                                                            //
+                            Damage,                                                             //
+                            OwningWeapon                                                        //
                         );
                     }
                 }
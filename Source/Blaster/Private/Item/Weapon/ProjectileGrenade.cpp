@@ -25,10 +25,24 @@ void AProjectileGrenade::BeginPlay()
 {
     AActor::BeginPlay();
 
+    ProjectileMovementComponent->OnProjectileBounce.AddDynamic(this, &ThisClass::OnBounce);
+
+    if (bStartDeactivated)
+    {
+        DeactivateProjectile();
+    }
+    else
+    {
+        ActivateProjectile();
+    }
+}
+
+void AProjectileGrenade::ActivateProjectile()
+{
+    Super::ActivateProjectile();
+
     SpawnTrailSystem();
     StartDestoryTimer();
-
-    ProjectileMovementComponent->OnProjectileBounce.AddDynamic(this, &ThisClass::OnBounce);
 }
 
 #if WITH_EDITOR
@@ -28,12 +28,16 @@ AProjectileRocket::AProjectileRocket()
     RocketMovementComponent->SetIsReplicated(true);
 }
 
-void AProjectileRocket::BeginPlay()
+void AProjectileRocket::ActivateProjectile()
 {
-    Super::BeginPlay();
+    Super::ActivateProjectile();
 
     SpawnTrailSystem();
-    if (ProjectileLoop && LoopingSoundAttenuation)
+    if (ProjectileLoopComponent)
+    {
+        ProjectileLoopComponent->Play();
+    }
+    else if (ProjectileLoop && LoopingSoundAttenuation)
     {
         ProjectileLoopComponent = UGameplayStatics::SpawnSoundAttached(  //
             ProjectileLoop,                                              //
@@ -70,6 +74,21 @@ void AProjectileRocket::BeginPlay()
     // UGameplayStatics::PredictProjectilePath(this, PathParams, PathResult);
 }
 
+void AProjectileRocket::DeactivateProjectile()
+{
+    Super::DeactivateProjectile();
+
+    if (ProjectileLoopComponent && ProjectileLoopComponent->IsPlaying())
+    {
+        ProjectileLoopComponent->Stop();
+    }
+}
+
+UProjectileMovementComponent* AProjectileRocket::GetProjectileMovement() const
+{
+    return RocketMovementComponent;
+}
+
 #if WITH_EDITOR
 void AProjectileRocket::PostEditChangeProperty(FPropertyChangedEvent& Event)
 {
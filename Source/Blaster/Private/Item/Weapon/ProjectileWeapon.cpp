@@ -4,14 +4,27 @@
 #include "Engine/World.h"
 #include "GameFramework/Pawn.h"
 #include "DrawDebugHelpers.h"
+#include "ProjectilePoolSubsystem.h"
 #include "ProjectileWeapon.h"
 
+void AProjectileWeapon::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Weapons come with the map and the players, their projectiles are ready before the first shot
+    if (UProjectilePoolSubsystem* ProjectilePool = GetWorld() ? GetWorld()->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+    {
+        ProjectilePool->Prewarm(ProjectileClass);
+    }
+}
+
 void AProjectileWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation)
 {
     Super::Fire(HitTarget, SocketLocation);
 
     APawn* InstigatorPawn = Cast<APawn>(GetOwner());
-    if (GetWorld() && InstigatorPawn && ProjectileClass)
+    UProjectilePoolSubsystem* ProjectilePool = GetWorld() ? GetWorld()->GetSubsystem<UProjectilePoolSubsystem>() : nullptr;
+    if (ProjectilePool && InstigatorPawn && ProjectileClass)
     {
         // FTransform SocketTransform = MuzzleFlashSocket->GetSocketTransform(GetWeaponMesh());
 
@@ -19,12 +32,8 @@ void AProjectileWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVec
         FVector ToTarget = HitTarget - SocketLocation;
         FRotator TargetRotation = ToTarget.Rotation();
 
-        FActorSpawnParameters SpawnParams;
-        SpawnParams.Owner = GetOwner();
-        SpawnParams.Instigator = InstigatorPawn;
-
         if (AProjectile* SpawnedProjectile =
-                GetWorld()->SpawnActor<AProjectile>(ProjectileClass, SocketLocation, TargetRotation, SpawnParams))
+                ProjectilePool->AcquireProjectile(ProjectileClass, SocketLocation, TargetRotation, GetOwner(), InstigatorPawn))
         {
             SpawnedProjectile->SetOwningWeapon(this);
             SetProjectileSSR(SpawnedProjectile, InstigatorPawn, SocketLocation);
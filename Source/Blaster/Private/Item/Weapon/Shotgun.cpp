@@ -7,13 +7,14 @@
 #include "Sound/SoundBase.h"
 #include "Particles/ParticleSystem.h"
 #include "GameFramework/DamageType.h"
-#include "Components/DecalComponent.h"
 #include "BlasterPlayerController.h"
 #include "LagCompensationComponent.h"
 #include "Shotgun.h"
 
-void AShotgun::FireShotgun(const TArray<FVector_NetQuantize100>& HitTargets, const FVector_NetQuantize100& SocketLocation)
+void AShotgun::FireShotgun(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation, int32 ScatterSeed)
 {
+    TArray<FVector_NetQuantize100> HitTargets;
+    ShotgunTraceEndWithScatter(HitTarget, SocketLocation, ScatterSeed, HitTargets);
     if (HitTargets.IsEmpty()) return;
     AWeapon::Fire(FVector(), FVector());
     APawn* OwnerPawn = Cast<APawn>(GetOwner());
@@ -26,10 +27,10 @@ void AShotgun::FireShotgun(const TArray<FVector_NetQuantize100>& HitTargets, con
 
         // Maps hit character to number of times hit
         TMap<ABlasterCharacter*, float> HitMap;
-        for (const FVector_NetQuantize100& HitTarget : HitTargets)
+        for (const FVector_NetQuantize100& PelletTarget : HitTargets)
         {
             FHitResult FireHit;
-            WeaponTraceHit(SocketLocation, HitTarget, FireHit);
+            WeaponTraceHit(SocketLocation, PelletTarget, FireHit);
 
             if (FireHit.bBlockingHit)
             {
@@ -37,26 +38,36 @@ void AShotgun::FireShotgun(const TArray<FVector_NetQuantize100>& HitTargets, con
                 Super::SpawnImpactFXAndSound(FireHit);
             }
         }
-        ApplyMultipleDamage(HitMap, OwnerPawn, InstigatorController, SocketLocation, HitTargets);
+        ApplyMultipleDamage(HitMap, OwnerPawn, InstigatorController, SocketLocation, HitTarget, ScatterSeed);
     }
 }
 
-void AShotgun::ShotgunTraceEndWithScatter(const FVector& HitTarget, TArray<FVector_NetQuantize100>& HitTargets)
+void AShotgun::ShotgunTraceEndWithScatter(
+    const FVector& HitTarget, const FVector& TraceStart, int32 ScatterSeed, TArray<FVector_NetQuantize100>& HitTargets)
 {
-
-    const FVector& TraceStart = GetTraceStart();
+    const FRandomStream Stream(ScatterSeed);
+    HitTargets.Reserve(HitTargets.Num() + NumberOfPellets);
     for (uint32 i = 0; i < NumberOfPellets; ++i)
     {
-        HitTargets.Add(TraceEndWithScatter(HitTarget, TraceStart));
+        HitTargets.Add(TraceEndWithScatter(HitTarget, TraceStart, Stream));
     }
 }
 
+void AShotgun::QuantizeScatterInputs(FVector_NetQuantize100& HitTarget, FVector_NetQuantize100& TraceStart)
+{
+    HitTarget = FVector(FMath::RoundToDouble(HitTarget.X * 100.0) / 100.0,  //
+        FMath::RoundToDouble(HitTarget.Y * 100.0) / 100.0,                   //
+        FMath::RoundToDouble(HitTarget.Z * 100.0) / 100.0);
+    TraceStart = FVector(FMath::RoundToDouble(TraceStart.X), FMath::RoundToDouble(TraceStart.Y), FMath::RoundToDouble(TraceStart.Z));
+}
+
 void AShotgun::ApplyMultipleDamage(            //
     TMap<ABlasterCharacter*, float>& HitMap,  //
     APawn* OwnerPawn,                          //
     AController* InstigatorController,         //
     const FVector& Start,                      //
-    const TArray<FVector_NetQuantize100>& HitTargets)
+    const FVector& HitTarget,                  //
+    int32 ScatterSeed)
 {
     TArray<ABlasterCharacter*> HitCharacters;
     for (auto HitPair : HitMap)
@@ -82,21 +93,21 @@ void AShotgun::ApplyMultipleDamage(            //
                                    BlasterOwnerCharacter->IsLocallyControlled() &&          //
                                    IsBlasterOwnerControllerValid() &&                       //
                                    BlasterOwnerCharacter->GetLagCompensationComponent() &&  //
-                                   !HitCharacters.IsEmpty() &&                              //
-                                   !HitTargets.IsEmpty();                                   //
+                                   !HitCharacters.IsEmpty();
 
     if (bServerSideRewindDamage)
     {
         // Hacked client
         // Damage = 10000;
 
-        float HitTime = BlasterOwnerController->GetServerTime() - BlasterOwnerController->SingleTripTime;
-        BlasterOwnerCharacter->GetLagCompensationComponent()->ShotgunServerScoreRequest(  //
-            HitCharacters,                                                                //
-            Start,                                                                        //
-            HitTargets,                                                                   //
-            HitTime,                                                                      //
-            Damage,                                                                       //
+        float HitTime = BlasterOwnerController->GetServerTime() - BlasterOwnerController->SingleTripTime - ShotTimeOffset;
+        BlasterOwnerCharacter->GetLagCompensationComponent()->ShotgunScoreRequest(  //
+            HitCharacters,                                                          //
+            Start,                                                                  //
+            HitTarget,                                                              //
+            ScatterSeed,                                                            //
+            HitTime,                                                                //
+            Damage,                                                                 //
             this);
     }
 }
@@ -107,26 +118,19 @@ void AShotgun::AddToHitMap(FHitResult& FireHit, TMap<ABlasterCharacter*, float>&
     {
         if (ABlasterCharacter* BlasterCharacter = Cast<ABlasterCharacter>(FireHit.GetActor()))
         {
-            UPhysicalMaterial* PhysMat = FireHit.PhysMaterial.Get();
-            if (BlasterCharacter->DamageModifiers.Contains(PhysMat))
+            float DamageModifier = 1.f;
+            if (BlasterCharacter->GetDamageModifier(FireHit.PhysMaterial.Get(), DamageModifier))
             {
-                if (OutHitMap.Contains(BlasterCharacter))
-                {
-                    OutHitMap[BlasterCharacter] += BlasterCharacter->DamageModifiers[PhysMat];
-                }
-                else
-                {
-                    OutHitMap.Emplace(BlasterCharacter, BlasterCharacter->DamageModifiers[PhysMat]);
-                }
+                OutHitMap.FindOrAdd(BlasterCharacter) += DamageModifier;
             }
         }
     }
 }
 
-void AShotgun::SpawnImpactSound(FHitResult& FireHit, FImpactData& ImpactData)
+FImpactEvent AShotgun::MakeImpactEvent(const FHitResult& FireHit)
 {
-    if (ImpactData.ImpactSound)
-    {
-        UGameplayStatics::PlaySoundAtLocation(this, ImpactData.ImpactSound, FireHit.ImpactPoint, .5f, FMath::FRandRange(-.5f, .5f));
-    }
+    FImpactEvent Impact = Super::MakeImpactEvent(FireHit);
+    Impact.SoundVolume = .5f;
+    Impact.SoundPitch = FMath::FRandRange(-.5f, .5f);
+    return Impact;
 }
@@ -7,6 +7,7 @@
 #include "Components/WidgetComponent.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "Casing.h"
+#include "CasingSubsystem.h"
 #include "BlasterPlayerController.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "TimerManager.h"
@@ -55,10 +56,11 @@ void AWeapon::Fire(const FVector_NetQuantize100& HitTarget, const FVector_NetQua
         ItemMesh->PlayAnimation(FireAnimation, false);
     }
     const USkeletalMeshSocket* AmmoEjectSocket = ItemMesh->GetSocketByName(FName("AmmoEject"));
-    if (AmmoEjectSocket && GetWorld() && CasingClass)
+    UCasingSubsystem* CasingSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UCasingSubsystem>() : nullptr;
+    if (AmmoEjectSocket && CasingSubsystem && CasingClass)
     {
         FTransform SocketTransform = AmmoEjectSocket->GetSocketTransform(ItemMesh);
-        GetWorld()->SpawnActor<ACasing>(CasingClass, SocketTransform.GetLocation(), SocketTransform.GetRotation().Rotator());
+        CasingSubsystem->EjectCasing(CasingClass, SocketTransform, GetOwner());
     }
     SpendRound();
 }
@@ -222,6 +224,12 @@ void AWeapon::ClientUpdateAmmo_Implementation(int32 ServerAmmo)
     SetHUDAmmo();
 }
 
+void AWeapon::RefundRejectedRound()
+{
+    // The server's ammo is unchanged, the update settles the client's pending round against it
+    ClientUpdateAmmo(Ammo);
+}
+
 void AWeapon::AddAmmo(int32 AmmoToAdd)
 {
     Ammo = FMath::Clamp(Ammo + AmmoToAdd, 0, MagCapacity);
@@ -281,11 +289,16 @@ bool AWeapon::IsFull()
 }
 
 FVector AWeapon::TraceEndWithScatter(const FVector& HitTarget, const FVector& TraceStart)
+{
+    return TraceEndWithScatter(HitTarget, TraceStart, FRandomStream(FMath::Rand()));
+}
+
+FVector AWeapon::TraceEndWithScatter(const FVector& HitTarget, const FVector& TraceStart, const FRandomStream& Stream)
 {
     const FVector ToTargetNormalized = (HitTarget - TraceStart).GetSafeNormal();
     const FVector SphereCenter = TraceStart + ToTargetNormalized * DistanceToSphere;
 
-    const FVector RandVec = UKismetMathLibrary::RandomUnitVector() * FMath::FRandRange(0.f, SphereRadius);
+    const FVector RandVec = Stream.GetUnitVector() * Stream.FRandRange(0.f, SphereRadius);
     const FVector EndLoc = SphereCenter + RandVec;
     const FVector ToEndLoc = EndLoc - TraceStart;
     /*
@@ -7,10 +7,10 @@
 #include "Blaster.h"
 #include "CarryItemTypes.h"
 #include "NiagaraComponent.h"
-#include "NiagaraFunctionLibrary.h"
 #include "BlasterCharacter.h"
 #include "BlasterUtils.h"
 #include "TimerManager.h"
+#include "FXPoolSubsystem.h"
 #include "Pickup.h"
 
 APickup::APickup()
@@ -47,6 +47,11 @@ void APickup::BeginPlay()
     Super::BeginPlay();
 
     GetWorldTimerManager().SetTimer(BindOverlapTimer, this, &ThisClass::BindOverlapTimerFinished, BindOverlapTime);
+
+    if (UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr)
+    {
+        FXPool->Prewarm(PickupEffect, 1);
+    }
 }
 
 void APickup::Tick(float DeltaTime)
@@ -88,21 +93,18 @@ void APickup::PlayPickupSound(AActor* OtherActor)
 void APickup::HandleOverlappingCharacter(AActor* OtherActor)
 {
 
-    if (PickupEffect && IsBlasterCharacterValid(OtherActor))
+    UFXPoolSubsystem* FXPool = GetWorld() ? GetWorld()->GetSubsystem<UFXPoolSubsystem>() : nullptr;
+    if (PickupEffect && FXPool && IsBlasterCharacterValid(OtherActor))
     {
-        if (BlasterCharacter->GetPickupEffect())
-        {
-            BlasterCharacter->GetPickupEffect()->DeactivateImmediate();
-        }
-
-        UNiagaraComponent* LastPickupEffect = UNiagaraFunctionLibrary::SpawnSystemAttached(  //
-            PickupEffect,                                                                    //
-            BlasterCharacter->GetRootComponent(),                                            //
-            NAME_None,                                                                       //
-            BlasterCharacter->GetActorLocation(),                                            //
-            BlasterCharacter->GetActorRotation(),                                            //
-            EAttachLocation::KeepWorldPosition,                                              //
-            false);
+        // The character keeps its effect until the next pickup or its elimination
+        FXPool->ReleaseFX(BlasterCharacter->GetPickupEffect());
+
+        UNiagaraComponent* LastPickupEffect = FXPool->SpawnSystemAttached(  //
+            PickupEffect,                                                   //
+            BlasterCharacter->GetRootComponent(),                           //
+            BlasterCharacter->GetActorLocation(),                           //
+            BlasterCharacter->GetActorRotation(),                           //
+            EFXPoolMethod::ManualRelease);
 
         BlasterCharacter->SetPickupEffect(LastPickupEffect);
     }
@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/SceneComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Kismet/KismetMathLibrary.h"
+#include "Sound/SoundBase.h"
+#include "Casing.h"
+#include "Blaster.h"
+#include "CasingSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Casings Tick"), STAT_CasingsTick, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Casings"), STAT_Casings, STATGROUP_Blaster);
+
+void UCasingSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!GetWorld()) return;
+
+    SCOPE_CYCLE_COUNTER(STAT_CasingsTick);
+    SoundBudget = FMath::Min(SoundBudget + ShellSoundsPerSecond * DeltaTime, ShellSoundsPerSecond);
+
+    const float GravityZ = GetWorld()->GetGravityZ();
+    const float DragFactor = FMath::Max(0.f, 1.f - Drag * DeltaTime);
+    for (TPair<UStaticMesh*, FCasingBatch>& Pair : Batches)
+    {
+        FCasingBatch& Batch = Pair.Value;
+        if (!IsValid(Batch.Instances)) continue;
+
+        // Backwards, so the casing swapped into a removed slot was already aged
+        for (int32 Index = Batch.Ages.Num() - 1; Index >= 0; --Index)
+        {
+            Batch.Ages[Index] += DeltaTime;
+            if (Batch.Ages[Index] > CasingLifeTime)
+            {
+                RemoveCasing(Batch, Index);
+            }
+        }
+        INC_DWORD_STAT_BY(STAT_Casings, Batch.Locations.Num());
+
+        bool bAnyMoving = false;
+        for (int32 Index = 0; Index < Batch.Locations.Num(); ++Index)
+        {
+            if (Batch.bResting[Index]) continue;
+            bAnyMoving = true;
+
+            FVector& Location = Batch.Locations[Index];
+            FVector& Velocity = Batch.Velocities[Index];
+            FVector& Spin = Batch.Spins[Index];
+
+            Velocity.Z += GravityZ * DeltaTime;
+            Velocity *= DragFactor;
+            Location += Velocity * DeltaTime;
+
+            const float SpinSpeed = Spin.Size();
+            if (SpinSpeed > UE_KINDA_SMALL_NUMBER)
+            {
+                Batch.Rotations[Index] = FQuat(Spin / SpinSpeed, SpinSpeed * DeltaTime) * Batch.Rotations[Index];
+            }
+
+            if (Location.Z > Batch.GroundHeights[Index]) continue;
+
+            // Bounce on the probed ground, the first contact is the one that rings
+            Location.Z = Batch.GroundHeights[Index];
+            if (!Batch.bLanded[Index])
+            {
+                Batch.bLanded[Index] = true;
+                if (Batch.ShellSound && ConsumeSoundBudget())
+                {
+                    UGameplayStatics::PlaySoundAtLocation(GetWorld(), Batch.ShellSound, Location);
+                }
+            }
+            Velocity.Z = -Velocity.Z * Restitution;
+            Velocity.X *= GroundFriction;
+            Velocity.Y *= GroundFriction;
+            Spin *= GroundFriction;
+            if (Velocity.Size() < RestSpeed)
+            {
+                Velocity = FVector::ZeroVector;
+                Batch.bResting[Index] = true;
+            }
+        }
+        if (!bAnyMoving) continue;
+
+        TransformsScratch.Reset(Batch.Locations.Num());
+        for (int32 Index = 0; Index < Batch.Locations.Num(); ++Index)
+        {
+            TransformsScratch.Emplace(Batch.Rotations[Index], Batch.Locations[Index], Batch.Scale);
+        }
+        Batch.Instances->BatchUpdateInstancesTransforms(0, TransformsScratch, true, true, true);
+    }
+}
+
+TStatId UCasingSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCasingSubsystem, STATGROUP_Tickables);
+}
+
+void UCasingSubsystem::Deinitialize()
+{
+    Batches.Empty();
+    InstancesOwner = nullptr;
+    Super::Deinitialize();
+}
+
+void UCasingSubsystem::EjectCasing(TSubclassOf<ACasing> CasingClass, const FTransform& EjectTransform, const AActor* IgnoredActor)
+{
+    // Nothing to see on a dedicated server
+    if (!CasingClass || !GetWorld() || GetWorld()->GetNetMode() == NM_DedicatedServer) return;
+
+    const ACasing* Casing = CasingClass->GetDefaultObject<ACasing>();
+    const UStaticMeshComponent* CasingMesh = Casing ? Casing->GetCasingMesh() : nullptr;
+    if (!CasingMesh || !CasingMesh->GetStaticMesh()) return;
+
+    FCasingBatch* Batch = FindOrAddBatch(CasingMesh->GetStaticMesh(), Casing->GetShellSound());
+    if (!Batch) return;
+    Batch->Scale = CasingMesh->GetRelativeScale3D();
+
+    if (Batch->Locations.Num() >= MaxCasingsPerBatch)
+    {
+        int32 Oldest = 0;
+        for (int32 Index = 1; Index < Batch->Ages.Num(); ++Index)
+        {
+            if (Batch->Ages[Index] > Batch->Ages[Oldest]) Oldest = Index;
+        }
+        RemoveCasing(*Batch, Oldest);
+    }
+
+    // The ground under the ejection point is the casing's only scene query
+    const FVector Location = EjectTransform.GetLocation();
+    FHitResult GroundHit;
+    const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CasingGroundProbe), false, IgnoredActor);
+    const bool bHitGround = GetWorld()->LineTraceSingleByChannel(  //
+        GroundHit,                                                 //
+        Location,                                                  //
+        Location - FVector(0.f, 0.f, GroundProbeDistance),         //
+        ECC_Visibility,                                            //
+        QueryParams);
+
+    const FVector Direction =
+        UKismetMathLibrary::RandomUnitVectorInConeInDegrees(EjectTransform.GetRotation().GetForwardVector(), EjectionConeDegrees);
+
+    Batch->Locations.Add(Location);
+    Batch->Velocities.Add(Direction * Casing->GetShellEjectionImpulse() * EjectionSpeedPerImpulse);
+    Batch->Rotations.Add(EjectTransform.GetRotation());
+    Batch->Spins.Add(FMath::VRand() * FMath::FRandRange(0.f, MaxSpinSpeed));
+    Batch->GroundHeights.Add(bHitGround ? GroundHit.ImpactPoint.Z : TNumericLimits<float>::Lowest());
+    Batch->Ages.Add(0.f);
+    Batch->bLanded.Add(false);
+    Batch->bResting.Add(false);
+    Batch->Instances->AddInstance(FTransform(EjectTransform.GetRotation(), Location, Batch->Scale), true);
+}
+
+FCasingBatch* UCasingSubsystem::FindOrAddBatch(UStaticMesh* Mesh, USoundBase* ShellSound)
+{
+    if (FCasingBatch* Batch = Batches.Find(Mesh))
+    {
+        return IsValid(Batch->Instances) ? Batch : nullptr;
+    }
+
+    if (!IsValid(InstancesOwner))
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        InstancesOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+        if (!InstancesOwner) return nullptr;
+
+        USceneComponent* Root = NewObject<USceneComponent>(InstancesOwner, TEXT("Root"));
+        InstancesOwner->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    UHierarchicalInstancedStaticMeshComponent* Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(InstancesOwner);
+    Instances->SetStaticMesh(Mesh);
+    Instances->SetMobility(EComponentMobility::Movable);
+    Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Instances->SetupAttachment(InstancesOwner->GetRootComponent());
+    Instances->RegisterComponent();
+    InstancesOwner->AddInstanceComponent(Instances);
+
+    FCasingBatch& Batch = Batches.Add(Mesh);
+    Batch.Instances = Instances;
+    Batch.ShellSound = ShellSound;
+    return &Batch;
+}
+
+void UCasingSubsystem::RemoveCasing(FCasingBatch& Batch, int32 Index)
+{
+    // The last instance moves into the removed slot, like the arrays
+    const int32 Last = Batch.Locations.Num() - 1;
+    if (Index != Last)
+    {
+        const FTransform LastTransform(Batch.Rotations[Last], Batch.Locations[Last], Batch.Scale);
+        Batch.Instances->UpdateInstanceTransform(Index, LastTransform, true, false, true);
+    }
+    Batch.Instances->RemoveInstance(Last);
+
+    Batch.Locations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.Rotations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.Spins.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.GroundHeights.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.Ages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.bLanded.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+    Batch.bResting.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+bool UCasingSubsystem::ConsumeSoundBudget()
+{
+    if (SoundBudget < 1.f) return false;
+    SoundBudget -= 1.f;
+    return true;
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GameFramework/Controller.h"
+#include "BlasterCharacter.h"
+#include "Blaster.h"
+#include "DamageQueueSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Damage Flush"), STAT_DamageFlush, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_DamageEvents, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damaged Characters"), STAT_DamagedCharacters, STATGROUP_Blaster);
+
+void UDamageQueueSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!PendingDamage.IsEmpty())
+    {
+        FlushDamage();
+    }
+}
+
+TStatId UDamageQueueSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UDamageQueueSubsystem::Deinitialize()
+{
+    PendingDamage.Empty();
+    FlushingDamage.Empty();
+    Super::Deinitialize();
+}
+
+void UDamageQueueSubsystem::QueueDamage(ABlasterCharacter* Victim, float Damage, AController* InstigatedBy, AActor* DamageCauser)
+{
+    if (!Victim) return;
+    INC_DWORD_STAT(STAT_DamageEvents);
+
+    FVictimDamage& VictimDamage = PendingDamage.FindOrAdd(Victim);
+    FQueuedDamage* Queued = VictimDamage.Attackers.FindByPredicate(  //
+        [InstigatedBy](const FQueuedDamage& Attacker) { return Attacker.InstigatedBy == InstigatedBy; });
+    if (!Queued)
+    {
+        Queued = &VictimDamage.Attackers.AddDefaulted_GetRef();
+        Queued->InstigatedBy = InstigatedBy;
+    }
+
+    Queued->Damage += Damage;
+    if (!Queued->DamageCauser || Damage > Queued->BiggestHit)
+    {
+        Queued->DamageCauser = DamageCauser;
+        Queued->BiggestHit = Damage;
+    }
+}
+
+void UDamageQueueSubsystem::FlushDamage()
+{
+    SCOPE_CYCLE_COUNTER(STAT_DamageFlush);
+    INC_DWORD_STAT_BY(STAT_DamagedCharacters, PendingDamage.Num());
+
+    Swap(PendingDamage, FlushingDamage);
+    for (const TPair<ABlasterCharacter*, FVictimDamage>& Pair : FlushingDamage)
+    {
+        if (IsValid(Pair.Key))
+        {
+            Pair.Key->ApplyFrameDamage(Pair.Value.Attackers);
+        }
+    }
+    FlushingDamage.Reset();
+}
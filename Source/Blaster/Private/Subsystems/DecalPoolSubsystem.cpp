@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Components/DecalComponent.h"
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "TimerManager.h"
+#include "CarryItemTypes.h"
+#include "DecalPoolSubsystem.h"
+
+void UDecalPoolSubsystem::Deinitialize()
+{
+    if (UWorld* World = GetWorld())
+    {
+        World->GetTimerManager().ClearTimer(HideExpiredTimer);
+    }
+    Rings.Empty();
+    NumDecals = 0;
+    DecalsOwner = nullptr;
+    Super::Deinitialize();
+}
+
+void UDecalPoolSubsystem::SpawnDecal(  //
+    const FDecalData& DecalData,        //
+    UPhysicalMaterial* PhysMaterial,    //
+    const FVector& Location,            //
+    const FRotator& Rotation)
+{
+    UWorld* World = GetWorld();
+    if (!DecalData.Material || !World || World->GetNetMode() == NM_DedicatedServer) return;
+
+    FPooledDecal* Pooled = TakeDecal(Rings.FindOrAdd(PhysMaterial));
+    if (!Pooled) return;
+
+    UDecalComponent* Decal = Pooled->Decal;
+    Decal->SetDecalMaterial(DecalData.Material);
+    Decal->DecalSize = DecalData.Size;
+    Decal->SetWorldLocationAndRotation(Location, Rotation);
+    Decal->SetFadeScreenSize(FadeScreenSize);
+
+    // Set instead of SetFadeOut, which also starts a life span that destroys the component. The render state
+    // restarts the fade from now, the pool hides the decal once it has faded
+    Decal->FadeStartDelay = DecalData.LifeTime;
+    Decal->FadeDuration = DecalData.FadeOutTime;
+    Decal->bDestroyOwnerAfterFade = false;
+    Decal->SetVisibility(true);
+    Decal->MarkRenderStateDirty();
+    Pooled->ExpireTime = World->GetTimeSeconds() + DecalData.LifeTime + DecalData.FadeOutTime;
+
+    if (!World->GetTimerManager().IsTimerActive(HideExpiredTimer))
+    {
+        World->GetTimerManager().SetTimer(HideExpiredTimer, this, &UDecalPoolSubsystem::HideExpiredDecals, HideExpiredInterval, true);
+    }
+}
+
+FPooledDecal* UDecalPoolSubsystem::TakeDecal(FDecalRing& Ring)
+{
+    // A full ring reuses its own oldest decal, at the global cap the fullest ring gives up its oldest
+    FDecalRing* SourceRing = nullptr;
+    if (Ring.Decals.Num() >= RingSizePerMaterial)
+    {
+        SourceRing = &Ring;
+    }
+    else if (NumDecals >= MaxDecals)
+    {
+        for (TPair<UPhysicalMaterial*, FDecalRing>& Other : Rings)
+        {
+            if (!SourceRing || Other.Value.Decals.Num() > SourceRing->Decals.Num())
+            {
+                SourceRing = &Other.Value;
+            }
+        }
+    }
+
+    if (SourceRing == &Ring && !Ring.Decals.IsEmpty())
+    {
+        FPooledDecal& Pooled = Ring.Decals[Ring.Next];
+        Ring.Next = (Ring.Next + 1) % Ring.Decals.Num();
+
+        // Something outside the pool destroyed it, a new decal takes its slot and its count
+        if (!IsValid(Pooled.Decal))
+        {
+            Pooled.Decal = CreateDecal();
+            if (!Pooled.Decal) return nullptr;
+        }
+        return &Pooled;
+    }
+
+    FPooledDecal Pooled;
+    if (SourceRing && !SourceRing->Decals.IsEmpty())
+    {
+        Pooled = SourceRing->Decals[SourceRing->Next];
+        SourceRing->Decals.RemoveAt(SourceRing->Next);
+        SourceRing->Next = SourceRing->Decals.IsEmpty() ? 0 : SourceRing->Next % SourceRing->Decals.Num();
+        if (!IsValid(Pooled.Decal))
+        {
+            Pooled.Decal = CreateDecal();
+            if (!Pooled.Decal)
+            {
+                --NumDecals;
+                return nullptr;
+            }
+        }
+    }
+    else
+    {
+        Pooled.Decal = CreateDecal();
+        if (!Pooled.Decal) return nullptr;
+        ++NumDecals;
+    }
+
+    // Inserted just before the oldest, it is the newest of the ring
+    const int32 Index = Ring.Next;
+    Ring.Decals.Insert(Pooled, Index);
+    Ring.Next = (Index + 1) % Ring.Decals.Num();
+    return &Ring.Decals[Index];
+}
+
+UDecalComponent* UDecalPoolSubsystem::CreateDecal()
+{
+    if (!IsValid(DecalsOwner))
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        DecalsOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+        if (!DecalsOwner) return nullptr;
+
+        USceneComponent* Root = NewObject<USceneComponent>(DecalsOwner, TEXT("Root"));
+        DecalsOwner->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    UDecalComponent* Decal = NewObject<UDecalComponent>(DecalsOwner);
+    Decal->SetupAttachment(DecalsOwner->GetRootComponent());
+    Decal->RegisterComponent();
+    return Decal;
+}
+
+void UDecalPoolSubsystem::HideExpiredDecals()
+{
+    const double Now = GetWorld()->GetTimeSeconds();
+    bool bAnyVisible = false;
+    for (TPair<UPhysicalMaterial*, FDecalRing>& Ring : Rings)
+    {
+        for (const FPooledDecal& Pooled : Ring.Value.Decals)
+        {
+            if (!IsValid(Pooled.Decal) || !Pooled.Decal->IsVisible()) continue;
+
+            if (Pooled.ExpireTime <= Now)
+            {
+                Pooled.Decal->SetVisibility(false);
+            }
+            else
+            {
+                bAnyVisible = true;
+            }
+        }
+    }
+
+    // Restarted by the next spawned decal
+    if (!bAnyVisible)
+    {
+        GetWorld()->GetTimerManager().ClearTimer(HideExpiredTimer);
+    }
+}
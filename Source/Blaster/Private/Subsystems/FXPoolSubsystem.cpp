@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Components/SceneComponent.h"
+#include "Engine/World.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "FXPoolSubsystem.h"
+
+namespace
+{
+UFXSystemAsset* GetFXAsset(const UFXSystemComponent* Component)
+{
+    if (const UParticleSystemComponent* ParticleComponent = Cast<UParticleSystemComponent>(Component))
+    {
+        return ParticleComponent->Template;
+    }
+    if (const UNiagaraComponent* NiagaraComponent = Cast<UNiagaraComponent>(Component))
+    {
+        return NiagaraComponent->GetAsset();
+    }
+    return nullptr;
+}
+}  // namespace
+
+void UFXPoolSubsystem::Deinitialize()
+{
+    Pools.Empty();
+    ComponentsOwner = nullptr;
+    Super::Deinitialize();
+}
+
+UParticleSystemComponent* UFXPoolSubsystem::SpawnEmitterAtLocation(UParticleSystem* Template,  //
+    const FTransform& Transform,                                                             //
+    EFXPoolMethod PoolMethod)
+{
+    UParticleSystemComponent* Component = Cast<UParticleSystemComponent>(AcquireComponent(Template, PoolMethod));
+    if (!Component) return nullptr;
+
+    Component->SetWorldTransform(Transform);
+    Component->Activate(true);
+    return Component;
+}
+
+UNiagaraComponent* UFXPoolSubsystem::SpawnSystemAttached(UNiagaraSystem* System,  //
+    USceneComponent* AttachToComponent,                                          //
+    const FVector& Location,                                                     //
+    const FRotator& Rotation,                                                    //
+    EFXPoolMethod PoolMethod)
+{
+    UNiagaraComponent* Component = Cast<UNiagaraComponent>(AcquireComponent(System, PoolMethod));
+    if (!Component) return nullptr;
+
+    if (AttachToComponent)
+    {
+        Component->AttachToComponent(AttachToComponent, FAttachmentTransformRules::KeepWorldTransform);
+    }
+    Component->SetWorldLocationAndRotation(Location, Rotation);
+    Component->Activate(true);
+    return Component;
+}
+
+void UFXPoolSubsystem::ReleaseFX(UFXSystemComponent* Component)
+{
+    if (!IsValid(Component)) return;
+
+    // Out of the active lists first, deactivating broadcasts the finish
+    ReturnToPool(Component);
+    Component->DeactivateImmediate();
+}
+
+void UFXPoolSubsystem::Prewarm(UFXSystemAsset* Asset, int32 Count)
+{
+    if (!Asset || !CanPlayFX()) return;
+
+    FFXComponentPool& Pool = Pools.FindOrAdd(Asset);
+    const int32 TargetCount = FMath::Min(Count > 0 ? Count : PrewarmCount, MaxFreePerAsset);
+    while (Pool.Free.Num() < TargetCount)
+    {
+        UFXSystemComponent* Component = CreateComponent(Asset);
+        if (!Component) return;
+        Pool.Free.Add(Component);
+    }
+}
+
+UFXSystemComponent* UFXPoolSubsystem::AcquireComponent(UFXSystemAsset* Asset, EFXPoolMethod PoolMethod)
+{
+    if (!Asset || !CanPlayFX()) return nullptr;
+
+    FFXComponentPool& Pool = Pools.FindOrAdd(Asset);
+    if (Pool.ActiveAuto.Num() + Pool.ActiveManual.Num() >= MaxActivePerAsset)
+    {
+        if (Pool.ActiveAuto.IsEmpty()) return nullptr;
+        ReleaseFX(Pool.ActiveAuto[0]);
+    }
+
+    UFXSystemComponent* Component = nullptr;
+    while (!Component && !Pool.Free.IsEmpty())
+    {
+        Component = Pool.Free.Pop(EAllowShrinking::No);
+        if (!IsValid(Component)) Component = nullptr;
+    }
+    if (!Component)
+    {
+        Component = CreateComponent(Asset);
+        if (!Component) return nullptr;
+    }
+
+    (PoolMethod == EFXPoolMethod::AutoRelease ? Pool.ActiveAuto : Pool.ActiveManual).Add(Component);
+    return Component;
+}
+
+UFXSystemComponent* UFXPoolSubsystem::CreateComponent(UFXSystemAsset* Asset)
+{
+    if (!IsValid(ComponentsOwner))
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        ComponentsOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+        if (!ComponentsOwner) return nullptr;
+
+        USceneComponent* Root = NewObject<USceneComponent>(ComponentsOwner, TEXT("Root"));
+        ComponentsOwner->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    UFXSystemComponent* Component = nullptr;
+    if (UParticleSystem* Template = Cast<UParticleSystem>(Asset))
+    {
+        UParticleSystemComponent* ParticleComponent = NewObject<UParticleSystemComponent>(ComponentsOwner);
+        ParticleComponent->bAutoActivate = false;
+        ParticleComponent->bAutoDestroy = false;
+        ParticleComponent->SetTemplate(Template);
+        ParticleComponent->OnSystemFinished.AddDynamic(this, &ThisClass::OnParticleSystemFinished);
+        Component = ParticleComponent;
+    }
+    else if (UNiagaraSystem* System = Cast<UNiagaraSystem>(Asset))
+    {
+        UNiagaraComponent* NiagaraComponent = NewObject<UNiagaraComponent>(ComponentsOwner);
+        NiagaraComponent->SetAutoActivate(false);
+        NiagaraComponent->SetAutoDestroy(false);
+        NiagaraComponent->SetAsset(System);
+        NiagaraComponent->OnSystemFinished.AddDynamic(this, &ThisClass::OnNiagaraSystemFinished);
+        Component = NiagaraComponent;
+    }
+    if (!Component) return nullptr;
+
+    Component->SetupAttachment(ComponentsOwner->GetRootComponent());
+    Component->RegisterComponent();
+    return Component;
+}
+
+void UFXPoolSubsystem::ReturnToPool(UFXSystemComponent* Component)
+{
+    FFXComponentPool* Pool = Pools.Find(GetFXAsset(Component));
+    if (!Pool) return;
+
+    const bool bWasActive = Pool->ActiveAuto.RemoveSingle(Component) > 0 || Pool->ActiveManual.RemoveSingle(Component) > 0;
+    if (!bWasActive) return;
+
+    // Effects attached to actors come back under the owner, so they don't die with the actor
+    if (ComponentsOwner && Component->GetAttachParent() != ComponentsOwner->GetRootComponent())
+    {
+        Component->AttachToComponent(ComponentsOwner->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
+    }
+
+    if (Pool->Free.Num() < MaxFreePerAsset)
+    {
+        Pool->Free.Add(Component);
+    }
+    else
+    {
+        Component->DestroyComponent();
+    }
+}
+
+bool UFXPoolSubsystem::CanPlayFX() const
+{
+    return GetWorld() && GetWorld()->GetNetMode() != NM_DedicatedServer;
+}
+
+void UFXPoolSubsystem::OnParticleSystemFinished(UParticleSystemComponent* Component)
+{
+    FFXComponentPool* Pool = Component ? Pools.Find(Component->Template) : nullptr;
+    if (Pool && Pool->ActiveAuto.Contains(Component))
+    {
+        ReturnToPool(Component);
+    }
+}
+
+void UFXPoolSubsystem::OnNiagaraSystemFinished(UNiagaraComponent* Component)
+{
+    FFXComponentPool* Pool = Component ? Pools.Find(Component->GetAsset()) : nullptr;
+    if (Pool && Pool->ActiveAuto.Contains(Component))
+    {
+        ReturnToPool(Component);
+    }
+}
@@ -0,0 +1,155 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Sound/SoundBase.h"
+#include "Blaster.h"
+#include "FXPoolSubsystem.h"
+#include "DecalPoolSubsystem.h"
+#include "ImpactSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Impacts Flush"), STAT_ImpactsFlush, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impacts Queued"), STAT_ImpactsQueued, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impacts Merged"), STAT_ImpactsMerged, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impacts Spawned"), STAT_ImpactsSpawned, STATGROUP_Blaster);
+
+FImpactEvent FImpactEvent::Make(const FImpactData& ImpactData, const FHitResult& Hit)
+{
+    FImpactEvent Impact;
+    Impact.ImpactParticles = ImpactData.ImpactParticles;
+    Impact.ImpactSound = ImpactData.ImpactSound;
+    Impact.DecalData = ImpactData.DecalData;
+    Impact.PhysMaterial = Hit.PhysMaterial.Get();
+    Impact.EffectLocation = Hit.ImpactPoint;
+    Impact.EffectRotation = Hit.ImpactNormal.Rotation();
+    Impact.DecalLocation = Hit.ImpactPoint;
+    Impact.DecalRotation = Impact.EffectRotation;
+    return Impact;
+}
+
+void UImpactSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    if (!PendingImpacts.IsEmpty())
+    {
+        FlushImpacts();
+    }
+}
+
+TStatId UImpactSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UImpactSubsystem, STATGROUP_Tickables);
+}
+
+bool UImpactSubsystem::WantsImpacts() const
+{
+    return GetWorld() && GetWorld()->GetNetMode() != NM_DedicatedServer;
+}
+
+void UImpactSubsystem::QueueImpact(const FImpactEvent& Impact)
+{
+    if (!WantsImpacts()) return;
+    INC_DWORD_STAT(STAT_ImpactsQueued);
+
+    const double MergeRadiusSquared = FMath::Square(MergeRadius);
+    for (FImpactEvent& Pending : PendingImpacts)
+    {
+        if (Pending.PhysMaterial == Impact.PhysMaterial &&                                             //
+            Pending.ImpactParticles == Impact.ImpactParticles &&                                       //
+            Pending.ImpactSound == Impact.ImpactSound &&                                               //
+            FVector::DistSquared(Pending.EffectLocation, Impact.EffectLocation) <= MergeRadiusSquared)  //
+        {
+            ++Pending.Count;
+            INC_DWORD_STAT(STAT_ImpactsMerged);
+            return;
+        }
+    }
+
+    if (PendingImpacts.Num() < MaxPendingImpacts)
+    {
+        PendingImpacts.Add(Impact);
+    }
+}
+
+void UImpactSubsystem::FlushImpacts()
+{
+    SCOPE_CYCLE_COUNTER(STAT_ImpactsFlush);
+
+    FVector ViewLocation = FVector::ZeroVector;
+    FRotator ViewRotation = FRotator::ZeroRotator;
+    const APlayerController* PlayerController = GetWorld() ? GetWorld()->GetFirstPlayerController() : nullptr;
+    const bool bHasView = PlayerController != nullptr;
+    if (bHasView)
+    {
+        PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+    }
+    const FVector ViewDirection = ViewRotation.Vector();
+    const double MaxDistanceSquared = FMath::Square(MaxImpactDistance);
+    const double AlwaysVisibleDistanceSquared = FMath::Square(AlwaysVisibleDistance);
+    const double ViewConeCos = FMath::Cos(FMath::DegreesToRadians(ViewConeDegrees));
+
+    // Nearest first, they are the ones a budget should not drop
+    RankScratch.Reset(PendingImpacts.Num());
+    for (int32 Index = 0; Index < PendingImpacts.Num(); ++Index)
+    {
+        const double DistanceSquared = bHasView ? FVector::DistSquared(ViewLocation, PendingImpacts[Index].EffectLocation) : 0.0;
+        if (DistanceSquared <= MaxDistanceSquared)
+        {
+            RankScratch.Emplace(DistanceSquared, Index);
+        }
+    }
+    RankScratch.Sort([](const TPair<double, int32>& A, const TPair<double, int32>& B) { return A.Key < B.Key; });
+
+    MaterialCountsScratch.Reset();
+    int32 Spawned = 0;
+    for (const TPair<double, int32>& Ranked : RankScratch)
+    {
+        if (Spawned >= MaxImpactsPerFrame) break;
+
+        const FImpactEvent& Impact = PendingImpacts[Ranked.Value];
+        int32& MaterialCount = MaterialCountsScratch.FindOrAdd(Impact.PhysMaterial);
+        if (MaterialCount >= MaxImpactsPerMaterialPerFrame) continue;
+
+        bool bInView = !bHasView || Ranked.Key <= AlwaysVisibleDistanceSquared;
+        if (!bInView)
+        {
+            const FVector ToImpact = (Impact.EffectLocation - ViewLocation).GetSafeNormal();
+            bInView = FVector::DotProduct(ToImpact, ViewDirection) >= ViewConeCos;
+        }
+
+        SpawnImpact(Impact, bInView);
+        ++MaterialCount;
+        ++Spawned;
+    }
+    INC_DWORD_STAT_BY(STAT_ImpactsSpawned, Spawned);
+
+    PendingImpacts.Reset();
+}
+
+void UImpactSubsystem::SpawnImpact(const FImpactEvent& Impact, bool bInView)
+{
+    // Sounds are heard out of view and decals outlive the moment, only particles need to be seen as they happen
+    if (Impact.ImpactSound)
+    {
+        const float VolumeScale = FMath::Min(1.f + MergedVolumePerImpact * (Impact.Count - 1), MaxMergedVolumeScale);
+        UGameplayStatics::PlaySoundAtLocation(  //
+            GetWorld(),                         //
+            Impact.ImpactSound,                 //
+            Impact.EffectLocation,              //
+            Impact.SoundVolume * VolumeScale,   //
+            Impact.SoundPitch);
+    }
+    UFXPoolSubsystem* FXPool = GetWorld()->GetSubsystem<UFXPoolSubsystem>();
+    if (bInView && Impact.ImpactParticles && FXPool)
+    {
+        FXPool->SpawnEmitterAtLocation(Impact.ImpactParticles, FTransform(Impact.EffectRotation, Impact.EffectLocation));
+    }
+    UDecalPoolSubsystem* DecalPool = GetWorld()->GetSubsystem<UDecalPoolSubsystem>();
+    if (Impact.bSpawnDecal && DecalPool)
+    {
+        DecalPool->SpawnDecal(Impact.DecalData, Impact.PhysMaterial, Impact.DecalLocation, Impact.DecalRotation);
+    }
+}
@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Projectile.h"
+#include "ProjectilePoolSubsystem.h"
+
+void UProjectilePoolSubsystem::Deinitialize()
+{
+    Pools.Empty();
+    Super::Deinitialize();
+}
+
+AProjectile* UProjectilePoolSubsystem::AcquireProjectile(TSubclassOf<AProjectile> ProjectileClass,  //
+    const FVector& Location,                                                                       //
+    const FRotator& Rotation,                                                                      //
+    AActor* Owner,                                                                                 //
+    APawn* Instigator)
+{
+    if (!ProjectileClass) return nullptr;
+
+    if (FProjectilePool* Pool = Pools.Find(ProjectileClass.Get()))
+    {
+        while (!Pool->Free.IsEmpty())
+        {
+            AProjectile* Projectile = Pool->Free.Pop(EAllowShrinking::No);
+            if (!IsValid(Projectile)) continue;
+
+            Projectile->SetOwner(Owner);
+            Projectile->SetInstigator(Instigator);
+            Projectile->SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+            Projectile->ActivateProjectile();
+            return Projectile;
+        }
+    }
+    return SpawnProjectile(ProjectileClass, Location, Rotation, Owner, Instigator, false);
+}
+
+void UProjectilePoolSubsystem::ReleaseProjectile(AProjectile* Projectile)
+{
+    if (!IsValid(Projectile)) return;
+
+    FProjectilePool& Pool = Pools.FindOrAdd(Projectile->GetClass());
+    if (Pool.Free.Num() >= MaxFreePerClass)
+    {
+        Projectile->Destroy();
+        return;
+    }
+    Projectile->DeactivateProjectile();
+    Projectile->ResetProjectile();
+    Pool.Free.Add(Projectile);
+}
+
+void UProjectilePoolSubsystem::Prewarm(TSubclassOf<AProjectile> ProjectileClass)
+{
+    if (!ProjectileClass || !GetWorld()) return;
+
+    FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass.Get());
+    const int32 ToSpawn = FMath::Min(PrewarmCount, MaxFreePerClass) - Pool.Free.Num();
+    for (int32 i = 0; i < ToSpawn; ++i)
+    {
+        if (AProjectile* Projectile = SpawnProjectile(ProjectileClass, FVector::ZeroVector, FRotator::ZeroRotator, nullptr, nullptr, true))
+        {
+            Pool.Free.Add(Projectile);
+        }
+    }
+}
+
+AProjectile* UProjectilePoolSubsystem::SpawnProjectile(TSubclassOf<AProjectile> ProjectileClass,  //
+    const FVector& Location,                                                                     //
+    const FRotator& Rotation,                                                                    //
+    AActor* Owner,                                                                               //
+    APawn* Instigator,                                                                           //
+    bool bStartDeactivated)
+{
+    if (!GetWorld()) return nullptr;
+
+    const FTransform SpawnTransform(Rotation, Location);
+    AProjectile* Projectile = GetWorld()->SpawnActorDeferred<AProjectile>(  //
+        ProjectileClass,                                                    //
+        SpawnTransform,                                                     //
+        Owner,                                                              //
+        Instigator,                                                         //
+        ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+    if (!Projectile) return nullptr;
+
+    Projectile->bStartDeactivated = bStartDeactivated;
+    Projectile->FinishSpawning(SpawnTransform);
+    return Projectile;
+}
@@ -0,0 +1,275 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "BlasterCharacter.h"
+#include "Weapon.h"
+#include "LagCompensationComponent.h"
+#include "Blaster.h"
+#include "BlasterRewindMath.h"
+#include "RewindSubsystem.h"
+#include "RewindBenchmark.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace
+{
+    constexpr int32 PlayerCounts[] = {8, 16, 32, 64};
+
+    // Characters stand on a grid, shots come from the shooter's spot in front of it
+    constexpr float GridSpacing = 300.f;
+    constexpr int32 ShotgunPellets = 10;
+
+    FAutoConsoleCommandWithWorldAndArgs RewindBenchmarkCommand(TEXT("Blaster.RewindBenchmark"),
+        TEXT("Benchmarks server-side rewind for 8 to 64 characters and writes a CSV to Saved/Profiling/Blaster. Args: [Iterations]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+            [](const TArray<FString>& Args, UWorld* World)
+            {
+                const int32 Iterations = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+                FRewindBenchmark::Run(World, FMath::Max(Iterations, 1));
+            }));
+
+    double Percentile(const TArray<double>& SortedSeconds, float Fraction)
+    {
+        if (SortedSeconds.IsEmpty()) return 0.0;
+        return SortedSeconds[FMath::Clamp(FMath::FloorToInt((SortedSeconds.Num() - 1) * Fraction), 0, SortedSeconds.Num() - 1)];
+    }
+
+    // Times one call and adds it to the samples
+    template <typename FunctionType>
+    void Measure(TArray<double>& OutSeconds, FunctionType&& Function)
+    {
+        const double StartSeconds = FPlatformTime::Seconds();
+        Function();
+        OutSeconds.Add(FPlatformTime::Seconds() - StartSeconds);
+    }
+}  // namespace
+
+void FRewindBenchmark::Run(UWorld* World, int32 Iterations)
+{
+    if (!World || World->GetNetMode() == NM_Client)
+    {
+        UE_LOG(LogBlaster, Warning, TEXT("Blaster.RewindBenchmark needs a server or standalone world"));
+        return;
+    }
+
+    FString Csv = TEXT("Players,Operation,Calls,CallsPerSecond,MeanUs,P50Us,P90Us,P99Us,MaxUs\n");
+    for (const int32 PlayerCount : PlayerCounts)
+    {
+        RunForPlayerCount(World, PlayerCount, Iterations, Csv);
+    }
+
+    const FString FileName = FString::Printf(TEXT("RewindBenchmark-%s.csv"), *FDateTime::Now().ToString());
+    const FString FilePath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("Blaster"), FileName);
+    if (FFileHelper::SaveStringToFile(Csv, *FilePath))
+    {
+        UE_LOG(LogBlaster, Display, TEXT("Blaster.RewindBenchmark results written to %s"), *FilePath);
+    }
+    else
+    {
+        UE_LOG(LogBlaster, Warning, TEXT("Blaster.RewindBenchmark couldn't write %s"), *FilePath);
+    }
+}
+
+void FRewindBenchmark::RunForPlayerCount(UWorld* World, int32 PlayerCount, int32 Iterations, FString& OutCsv)
+{
+    URewindSubsystem* RewindSubsystem = World->GetSubsystem<URewindSubsystem>();
+    if (!RewindSubsystem) return;
+
+    // The synthetic histories stretch the live subsystem's window, the game gets its own back afterwards
+    TGuardValue<float> RecordTimeGuard(RewindSubsystem->RecordTime, RewindSubsystem->RecordTime);
+
+    // Spawned characters register themselves with the rewind subsystem in BeginPlay, they are destroyed at the end
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    SpawnParams.ObjectFlags |= RF_Transient;
+
+    const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(PlayerCount)));
+    TArray<ABlasterCharacter*> Characters;
+    for (int32 Index = 0; Index < PlayerCount; ++Index)
+    {
+        const FVector Location((Index % GridSize) * GridSpacing, (Index / GridSize) * GridSpacing, 1000.f);
+        if (ABlasterCharacter* Character = World->SpawnActor<ABlasterCharacter>(Location, FRotator::ZeroRotator, SpawnParams))
+        {
+            Characters.Add(Character);
+        }
+    }
+    AWeapon* DamageCauser = World->SpawnActor<AWeapon>(FVector::ZeroVector, FRotator::ZeroRotator, SpawnParams);
+
+    if (Characters.Num() > 1 && DamageCauser)
+    {
+        const float Now = World->GetTimeSeconds();
+        RecordSyntheticHistories(RewindSubsystem, Characters, Now);
+
+        FSamples GetFrameSamples{TEXT("GetFrameToCheck")};
+        FSamples InterpSamples{TEXT("InterpBetweenFrames")};
+        FSamples HitScanSamples{TEXT("HitScanRequest")};
+        FSamples ShotgunSamples{TEXT("ShotgunRequest")};
+        FSamples ExplosionSamples{TEXT("ExplosionProjectileRequest")};
+
+        FRandomStream Random(PlayerCount);
+        FRewindDamageBatch DamageBatch;
+        ABlasterCharacter* Shooter = Characters[0];
+        ULagCompensationComponent* LagCompensation = Shooter->GetLagCompensationComponent();
+
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            ABlasterCharacter* Target = Characters[Random.RandRange(1, Characters.Num() - 1)];
+            const float HitTime = Now - Random.FRandRange(0.f, RewindSubsystem->GetRecordTime() * 0.9f);
+            const FVector TraceStart = Shooter->GetActorLocation();
+            const FVector TargetLocation = Target->GetActorLocation();
+
+            // Every call rewinds again, nothing is served from the frame cache
+            RewindSubsystem->FrameCache.Reset();
+            Measure(GetFrameSamples.Seconds, [&] { RewindSubsystem->GetFrameToCheck(Target, HitTime); });
+
+            const int32 HistoryIndex = RewindSubsystem->Characters.IndexOfByKey(Target);
+            const FFrameHistory& History = RewindSubsystem->Histories[HistoryIndex];
+            const int32 YoungerIndex = FMath::Clamp(History.UpperBound(HitTime), 1, History.Num() - 1);
+            FFramePackage Older;
+            FFramePackage Younger;
+            History.Decode(YoungerIndex - 1, Older);
+            History.Decode(YoungerIndex, Younger);
+            Measure(InterpSamples.Seconds, [&] { RewindSubsystem->InterpBetweenFrames(Older, Younger, HitTime); });
+
+            // Score requests go through the same prepare, solve and finish steps as a batch does
+            auto MeasureRequest = [&](FSamples& Samples, const FScoreRequest& Request)
+            {
+                RewindSubsystem->FrameCache.Reset();
+                Measure(Samples.Seconds,
+                    [&]
+                    {
+                        FRewindJob Job;
+                        LagCompensation->PrepareScoreRequest(Request, Job);
+                        BlasterRewindMath::SolveJob(Job);
+                        LagCompensation->FinishScoreRequest(Request, Job, DamageBatch);
+                    });
+                DamageBatch.Hits.Reset();
+                DamageBatch.Explosions.Reset();
+            };
+
+            FScoreRequest HitScanRequest;
+            HitScanRequest.Type = EScoreRequestType::HitScan;
+            HitScanRequest.Instigator = LagCompensation;
+            HitScanRequest.HitCharacters.Add(Target);
+            HitScanRequest.TraceStart = TraceStart;
+            HitScanRequest.HitLocations.Add(TargetLocation);
+            HitScanRequest.HitTime = HitTime;
+            HitScanRequest.Damage = 10.f;
+            HitScanRequest.DamageCauser = DamageCauser;
+            MeasureRequest(HitScanSamples, HitScanRequest);
+
+            FScoreRequest ShotgunRequest = HitScanRequest;
+            ShotgunRequest.Type = EScoreRequestType::Shotgun;
+            ShotgunRequest.HitCharacters = Characters;
+            ShotgunRequest.HitCharacters.RemoveAtSwap(0);
+            ShotgunRequest.HitLocations.Reset();
+            for (int32 Pellet = 0; Pellet < ShotgunPellets; ++Pellet)
+            {
+                ShotgunRequest.HitLocations.Add(TargetLocation + Random.VRand() * 40.f);
+            }
+            MeasureRequest(ShotgunSamples, ShotgunRequest);
+
+            FScoreRequest ExplosionRequest = ShotgunRequest;
+            ExplosionRequest.Type = EScoreRequestType::ExplosionProjectile;
+            ExplosionRequest.HitLocations.Reset();
+            ExplosionRequest.InitialVelocity = (TargetLocation - TraceStart).GetSafeNormal() * 3000.f;
+            ExplosionRequest.GravityScale = 0.f;
+            ExplosionRequest.DamageInnerRadius = 200.f;
+            ExplosionRequest.DamageOuterRadius = 500.f;
+            MeasureRequest(ExplosionSamples, ExplosionRequest);
+        }
+
+        for (const FSamples* Samples : {&GetFrameSamples, &InterpSamples, &HitScanSamples, &ShotgunSamples, &ExplosionSamples})
+        {
+            AppendCsvRow(PlayerCount, *Samples, OutCsv);
+        }
+    }
+
+    for (ABlasterCharacter* Character : Characters)
+    {
+        if (IsValid(Character))
+        {
+            Character->Destroy();
+        }
+    }
+    if (IsValid(DamageCauser))
+    {
+        DamageCauser->Destroy();
+    }
+
+    // Nothing the live game rewinds may be served from the benchmark's poses
+    RewindSubsystem->FrameCache.Reset();
+}
+
+void FRewindBenchmark::RecordSyntheticHistories(URewindSubsystem* RewindSubsystem, const TArray<ABlasterCharacter*>& Characters, float Now)
+{
+    const float RecordTime = FMath::Max(RewindSubsystem->RecordTime, RewindSubsystem->MinRecordTime);
+    const float Interval = RewindSubsystem->RecordInterval > 0.f ? RewindSubsystem->RecordInterval : 1.f / 60.f;
+    const int32 FrameCount = FMath::CeilToInt(RecordTime / Interval) + 1;
+    RewindSubsystem->RecordTime = RecordTime;
+
+    for (ABlasterCharacter* Character : Characters)
+    {
+        const int32 Index = RewindSubsystem->Characters.IndexOfByKey(Character);
+        if (Index == INDEX_NONE) continue;
+
+        FFrameHistory& History = RewindSubsystem->Histories[Index];
+        History.SetCapacity(FrameCount);
+        History.Reset();
+
+        // Strafing and turning, so no two frames are the same pose
+        const FVector Origin = Character->GetActorLocation();
+        for (int32 Frame = 0; Frame < FrameCount; ++Frame)
+        {
+            const float Time = Now - RecordTime + Frame * Interval;
+            const FVector Offset(FMath::Sin(Time * 3.f) * 100.f, FMath::Cos(Time * 2.f) * 100.f, 0.f);
+            const FQuat Rotation(FVector::UpVector, Time);
+
+            FFramePackage Package;
+            Package.Time = Time;
+            Package.Character = Character;
+            for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+            {
+                Package.Locations[Slot] = Origin + Offset + Rotation.RotateVector(FVector(0.f, 0.f, Slot * 8.f - 80.f));
+                Package.Rotations[Slot] = Rotation;
+                Package.BoxExtents[Slot] = Character->GetHitBoxExtent(Slot);
+            }
+            Package.Bounds = BlasterRewindMath::ComputeBounds(Package);
+            History.AddNewest(Package);
+        }
+    }
+}
+
+void FRewindBenchmark::AppendCsvRow(int32 PlayerCount, const FSamples& Samples, FString& OutCsv)
+{
+    TArray<double> Sorted = Samples.Seconds;
+    Sorted.Sort();
+
+    double TotalSeconds = 0.0;
+    for (const double Seconds : Sorted)
+    {
+        TotalSeconds += Seconds;
+    }
+    const double CallsPerSecond = TotalSeconds > 0.0 ? Sorted.Num() / TotalSeconds : 0.0;
+    const double MeanSeconds = Sorted.IsEmpty() ? 0.0 : TotalSeconds / Sorted.Num();
+
+    OutCsv += FString::Printf(TEXT("%d,%s,%d,%.1f,%.3f,%.3f,%.3f,%.3f,%.3f\n"),  //
+        PlayerCount,                                                            //
+        *Samples.Operation,                                                     //
+        Sorted.Num(),                                                           //
+        CallsPerSecond,                                                         //
+        MeanSeconds * 1e6,                                                      //
+        Percentile(Sorted, 0.5f) * 1e6,                                         //
+        Percentile(Sorted, 0.9f) * 1e6,                                         //
+        Percentile(Sorted, 0.99f) * 1e6,                                        //
+        Percentile(Sorted, 1.f) * 1e6);
+}
+
+#else
+
+void FRewindBenchmark::Run(UWorld* World, int32 Iterations) {}
+
+#endif
@@ -0,0 +1,633 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerState.h"
+#include "Kismet/GameplayStatics.h"
+#include "GameFramework/DamageType.h"
+#include "Algo/StableSort.h"
+#include "Async/ParallelFor.h"
+#include "BlasterCharacter.h"
+#include "BlasterGameplayStatics.h"
+#include "BlasterRewindMath.h"
+#include "Blaster.h"
+#include "RewindSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rewind Record Frames"), STAT_RewindRecordFrames, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Process Requests"), STAT_RewindProcessRequests, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Solve Jobs"), STAT_RewindSolveJobs, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Apply Damage"), STAT_RewindApplyDamage, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Get Frame To Check"), STAT_RewindGetFrameToCheck, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Interp Between Frames"), STAT_RewindInterpBetweenFrames, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Hit Scan"), STAT_RewindHitScan, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Projectile"), STAT_RewindProjectile, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Explosion Projectile"), STAT_RewindExplosionProjectile, STATGROUP_Blaster);
+DECLARE_CYCLE_STAT(TEXT("Rewind Shotgun"), STAT_RewindShotgun, STATGROUP_Blaster);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Score Requests"), STAT_RewindScoreRequests, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Confirmed Requests"), STAT_RewindConfirmedRequests, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rejected Requests"), STAT_RewindRejectedRequests, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Interpolated"), STAT_RewindFramesInterpolated, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frame Cache Hits"), STAT_RewindFrameCacheHits, STATGROUP_Blaster);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Frames Recorded"), STAT_RewindFramesRecorded, STATGROUP_Blaster);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Max Rewind Depth (ms)"), STAT_RewindMaxDepth, STATGROUP_Blaster);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Record Time (ms)"), STAT_RewindRecordTime, STATGROUP_Blaster);
+
+namespace
+{
+    // 1/64 cm steps, hit boxes up to 512 cm away from the root
+    constexpr float PositionScale = 64.f;
+
+    constexpr int32 QuatComponentBits = 10;
+    constexpr uint32 QuatComponentMask = (1u << QuatComponentBits) - 1;
+
+    int16 QuantizePosition(double Value)
+    {
+        return static_cast<int16>(FMath::Clamp<int32>(FMath::RoundToInt(Value * PositionScale), MIN_int16, MAX_int16));
+    }
+
+    // Drops the largest component, its sign is flipped to positive so it can be rebuilt from the other three
+    uint32 PackQuat(const FQuat& Rotation)
+    {
+        const FQuat4f Quat = FQuat4f(Rotation).GetNormalized();
+        const float Components[4] = {Quat.X, Quat.Y, Quat.Z, Quat.W};
+
+        int32 Largest = 0;
+        for (int32 Index = 1; Index < 4; ++Index)
+        {
+            if (FMath::Abs(Components[Index]) > FMath::Abs(Components[Largest]))
+            {
+                Largest = Index;
+            }
+        }
+        const float Sign = Components[Largest] < 0.f ? -1.f : 1.f;
+
+        uint32 Packed = static_cast<uint32>(Largest) << (3 * QuatComponentBits);
+        int32 Shift = 2 * QuatComponentBits;
+        for (int32 Index = 0; Index < 4; ++Index)
+        {
+            if (Index == Largest) continue;
+
+            // The other components are within +-1/sqrt(2)
+            const float Normalized = FMath::Clamp(Components[Index] * Sign * UE_SQRT_2 * 0.5f + 0.5f, 0.f, 1.f);
+            Packed |= static_cast<uint32>(FMath::RoundToInt(Normalized * QuatComponentMask)) << Shift;
+            Shift -= QuatComponentBits;
+        }
+        return Packed;
+    }
+
+    FQuat UnpackQuat(uint32 Packed)
+    {
+        const int32 Largest = Packed >> (3 * QuatComponentBits);
+
+        float Components[4];
+        float SumSquared = 0.f;
+        int32 Shift = 2 * QuatComponentBits;
+        for (int32 Index = 0; Index < 4; ++Index)
+        {
+            if (Index == Largest) continue;
+
+            const float Normalized = static_cast<float>((Packed >> Shift) & QuatComponentMask) / QuatComponentMask;
+            Components[Index] = (Normalized - 0.5f) * 2.f * UE_INV_SQRT_2;
+            SumSquared += FMath::Square(Components[Index]);
+            Shift -= QuatComponentBits;
+        }
+        Components[Largest] = FMath::Sqrt(FMath::Max(1.f - SumSquared, 0.f));
+
+        return FQuat(FQuat4f(Components[0], Components[1], Components[2], Components[3]).GetNormalized());
+    }
+
+    bool IsSameQuat(uint32 A, uint32 B)
+    {
+        if ((A >> (3 * QuatComponentBits)) != (B >> (3 * QuatComponentBits))) return false;
+        for (int32 Shift = 0; Shift < 3 * QuatComponentBits; Shift += QuatComponentBits)
+        {
+            const int32 ComponentA = (A >> Shift) & QuatComponentMask;
+            const int32 ComponentB = (B >> Shift) & QuatComponentMask;
+            if (FMath::Abs(ComponentA - ComponentB) > 1) return false;
+        }
+        return true;
+    }
+
+    TStatId GetScoreRequestStatId(EScoreRequestType Type)
+    {
+        switch (Type)
+        {
+            case EScoreRequestType::HitScan: return GET_STATID(STAT_RewindHitScan);
+            case EScoreRequestType::Projectile: return GET_STATID(STAT_RewindProjectile);
+            case EScoreRequestType::ExplosionProjectile: return GET_STATID(STAT_RewindExplosionProjectile);
+            case EScoreRequestType::Shotgun: return GET_STATID(STAT_RewindShotgun);
+        }
+        return TStatId();
+    }
+
+    // Game thread time of the requests of one weapon type in the current batch, for the CSV profiler
+    struct FScoreRequestTypeTimes
+    {
+        double Seconds[4] = {};
+
+        void Add(EScoreRequestType Type, double InSeconds) { Seconds[static_cast<uint8>(Type)] += InSeconds; }
+
+        void Report() const
+        {
+            CSV_CUSTOM_STAT(Blaster, RewindHitScanMs, Seconds[0] * 1000.0, ECsvCustomStatOp::Accumulate);
+            CSV_CUSTOM_STAT(Blaster, RewindProjectileMs, Seconds[1] * 1000.0, ECsvCustomStatOp::Accumulate);
+            CSV_CUSTOM_STAT(Blaster, RewindExplosionProjectileMs, Seconds[2] * 1000.0, ECsvCustomStatOp::Accumulate);
+            CSV_CUSTOM_STAT(Blaster, RewindShotgunMs, Seconds[3] * 1000.0, ECsvCustomStatOp::Accumulate);
+        }
+    };
+}  // namespace
+
+void FFrameHistory::Init(int32 InCapacity)
+{
+    Frames.SetNum(FMath::Max(InCapacity, 2));
+    Reset();
+}
+
+void FFrameHistory::Reset()
+{
+    Head = 0;
+    Count = 0;
+}
+
+void FFrameHistory::SetCapacity(int32 InCapacity)
+{
+    const int32 NewCapacity = FMath::Max(InCapacity, 2);
+    if (NewCapacity == Frames.Num()) return;
+
+    const int32 Kept = FMath::Min(Count, NewCapacity);
+    TArray<FCompressedFrame> NewFrames;
+    NewFrames.SetNum(NewCapacity);
+    for (int32 Index = 0; Index < Kept; ++Index)
+    {
+        NewFrames[Index] = GetFrame(Count - Kept + Index);
+    }
+    Frames = MoveTemp(NewFrames);
+    Head = 0;
+    Count = Kept;
+}
+
+bool FFrameHistory::AddNewest(const FFramePackage& Package)
+{
+    check(Frames.Num() > 0);
+    FCompressedFrame NewFrame;
+    Encode(Package, NewFrame);
+
+    if (Count > 0)
+    {
+        FCompressedFrame& Newest = Frames[(Head + Count - 1) % Frames.Num()];
+        if (IsSamePose(Newest, NewFrame))
+        {
+            Newest.EndTime = Package.Time;
+            return false;
+        }
+    }
+
+    if (Count == Frames.Num())
+    {
+        RemoveOldest();
+    }
+    Frames[(Head + Count) % Frames.Num()] = NewFrame;
+    ++Count;
+    return true;
+}
+
+void FFrameHistory::Encode(const FFramePackage& Package, FCompressedFrame& Frame)
+{
+    Frame.Time = Package.Time;
+    Frame.EndTime = Package.Time;
+    Frame.bHasBounds = Package.Bounds.IsValid != 0;
+    Frame.Root = Frame.bHasBounds ? Package.Bounds.GetCenter() : FVector::ZeroVector;
+
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        const FVector Offset = Package.Locations[Slot] - Frame.Root;
+        for (int32 Axis = 0; Axis < 3; ++Axis)
+        {
+            Frame.Locations[Slot][Axis] = QuantizePosition(Offset[Axis]);
+        }
+        Frame.Rotations[Slot] = PackQuat(Package.Rotations[Slot]);
+        BoxExtents[Slot] = Package.BoxExtents[Slot];
+    }
+
+    // Rounded outwards so the decoded bounds still enclose every box
+    const FVector MinOffset = Frame.bHasBounds ? Package.Bounds.Min - Frame.Root : FVector::ZeroVector;
+    const FVector MaxOffset = Frame.bHasBounds ? Package.Bounds.Max - Frame.Root : FVector::ZeroVector;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        Frame.BoundsMin[Axis] = QuantizePosition(FMath::FloorToDouble(MinOffset[Axis] * PositionScale) / PositionScale);
+        Frame.BoundsMax[Axis] = QuantizePosition(FMath::CeilToDouble(MaxOffset[Axis] * PositionScale) / PositionScale);
+    }
+}
+
+bool FFrameHistory::IsSamePose(const FCompressedFrame& A, const FCompressedFrame& B)
+{
+    if (A.bHasBounds != B.bHasBounds || !A.Root.Equals(B.Root, 1.f / PositionScale)) return false;
+
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        for (int32 Axis = 0; Axis < 3; ++Axis)
+        {
+            if (FMath::Abs(A.Locations[Slot][Axis] - B.Locations[Slot][Axis]) > 1) return false;
+        }
+        if (!IsSameQuat(A.Rotations[Slot], B.Rotations[Slot])) return false;
+    }
+    return true;
+}
+
+void FFrameHistory::RemoveOldest()
+{
+    if (Count == 0) return;
+    Head = (Head + 1) % Frames.Num();
+    --Count;
+}
+
+int32 FFrameHistory::UpperBound(float Time) const
+{
+    int32 First = 0;
+    int32 Size = Count;
+    while (Size > 0)
+    {
+        const int32 Step = Size / 2;
+        const int32 Middle = First + Step;
+        if (GetTime(Middle) <= Time)
+        {
+            First = Middle + 1;
+            Size -= Step + 1;
+        }
+        else
+        {
+            Size = Step;
+        }
+    }
+    return First;
+}
+
+void FFrameHistory::Decode(int32 Index, FFramePackage& OutPackage) const
+{
+    const FCompressedFrame& Frame = GetFrame(Index);
+    OutPackage.Time = Frame.Time;
+    OutPackage.Character = nullptr;
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        const int16* Location = Frame.Locations[Slot];
+        OutPackage.Locations[Slot] = Frame.Root + FVector(Location[0], Location[1], Location[2]) / PositionScale;
+        OutPackage.Rotations[Slot] = UnpackQuat(Frame.Rotations[Slot]);
+        OutPackage.BoxExtents[Slot] = BoxExtents[Slot];
+    }
+    OutPackage.Bounds = GetBounds(Index);
+}
+
+FBox FFrameHistory::GetBounds(int32 Index) const
+{
+    const FCompressedFrame& Frame = GetFrame(Index);
+    if (!Frame.bHasBounds) return FBox(ForceInit);
+
+    const FVector Min(Frame.BoundsMin[0], Frame.BoundsMin[1], Frame.BoundsMin[2]);
+    const FVector Max(Frame.BoundsMax[0], Frame.BoundsMax[1], Frame.BoundsMax[2]);
+    return FBox(Frame.Root + Min / PositionScale, Frame.Root + Max / PositionScale);
+}
+
+void URewindSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    ProcessScoreRequests();
+    if (Characters.IsEmpty() || !GetWorld()) return;
+
+    UpdateRecordTime(DeltaTime);
+
+    // Tickable objects run after every tick group, so the hit boxes already follow this frame's animation
+    const float Time = GetWorld()->GetTimeSeconds();
+    if (Time < NextRecordTime) return;
+    NextRecordTime = FMath::Max(NextRecordTime + RecordInterval, Time);
+
+    SCOPE_CYCLE_COUNTER(STAT_RewindRecordFrames);
+    CSV_SCOPED_TIMING_STAT(Blaster, RewindRecordFrames);
+    for (int32 Index = 0; Index < Characters.Num(); ++Index)
+    {
+        // Eliminated characters can't be damaged, their history just stops at the last frame
+        if (IsValid(Characters[Index]) && !Characters[Index]->IsElimmed())
+        {
+            RecordFrame(Characters[Index], Histories[Index], Time);
+        }
+    }
+}
+
+TStatId URewindSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(URewindSubsystem, STATGROUP_Tickables);
+}
+
+void URewindSubsystem::RegisterCharacter(ABlasterCharacter* Character)
+{
+    if (!Character || Characters.Contains(Character)) return;
+
+    Characters.Add(Character);
+    Histories.AddDefaulted_GetRef().Init(GetHistoryCapacity());
+}
+
+void URewindSubsystem::UnregisterCharacter(ABlasterCharacter* Character)
+{
+    const int32 Index = Characters.IndexOfByKey(Character);
+    if (Index == INDEX_NONE) return;
+
+    Characters.RemoveAtSwap(Index);
+    Histories.RemoveAtSwap(Index);
+}
+
+int32 URewindSubsystem::GetHistoryCapacity() const
+{
+    // At most one frame is recorded per server tick and per RecordInterval, unchanged poses don't add any
+    float FramesPerSecond = DefaultServerTickRate;
+    if (GetWorld() && GetWorld()->GetNetDriver() && GetWorld()->GetNetDriver()->GetNetServerMaxTickRate() > 0)
+    {
+        FramesPerSecond = GetWorld()->GetNetDriver()->GetNetServerMaxTickRate();
+    }
+    if (RecordInterval > 0.f)
+    {
+        FramesPerSecond = FMath::Min(FramesPerSecond, 1.f / RecordInterval);
+    }
+    return FMath::CeilToInt(FMath::Max(RecordTime, MinRecordTime) * FramesPerSecond) + 1;
+}
+
+void URewindSubsystem::UpdateRecordTime(float DeltaTime)
+{
+    float WorstLatency = 0.f;
+    if (const AGameStateBase* GameState = GetWorld()->GetGameState())
+    {
+        for (const APlayerState* PlayerState : GameState->PlayerArray)
+        {
+            if (PlayerState)
+            {
+                WorstLatency = FMath::Max(WorstLatency, PlayerState->GetPingInMilliseconds() * 0.001f);
+            }
+        }
+    }
+    PeakLatency = FMath::Max(WorstLatency, PeakLatency - LatencyDecayRate * DeltaTime);
+    RecordTime = FMath::Clamp(PeakLatency + RecordTimeMargin, MinRecordTime, MaxRecordTime);
+    SET_FLOAT_STAT(STAT_RewindRecordTime, RecordTime * 1000.f);
+    CSV_CUSTOM_STAT(Blaster, RewindRecordTimeMs, RecordTime * 1000.f, ECsvCustomStatOp::Set);
+
+    // Grows right away, shrinks only once the window halved so a wobbling ping doesn't reallocate every tick
+    const int32 Capacity = GetHistoryCapacity();
+    for (FFrameHistory& History : Histories)
+    {
+        if (History.Capacity() < Capacity || History.Capacity() > Capacity * 2)
+        {
+            History.SetCapacity(Capacity);
+        }
+    }
+}
+
+void URewindSubsystem::RecordFrame(ABlasterCharacter* Character, FFrameHistory& History, float Time)
+{
+    FFramePackage Package;
+    Package.Time = Time;
+    Package.Character = Character;
+    Character->CaptureHitBoxes(Package);
+    Package.Bounds = BlasterRewindMath::ComputeBounds(Package);
+    if (History.AddNewest(Package))
+    {
+        INC_DWORD_STAT(STAT_RewindFramesRecorded);
+    }
+
+    while (History.Num() > 1 && History.GetNewestTime() - History.GetEndTime(0) > RecordTime)
+    {
+        History.RemoveOldest();
+    }
+}
+
+void URewindSubsystem::QueueScoreRequest(FScoreRequest&& Request)
+{
+    // How far back the shooter needs the world, the window follows it up to MaxRecordTime
+    if (GetWorld())
+    {
+        PeakLatency = FMath::Max(PeakLatency, GetWorld()->GetTimeSeconds() - Request.HitTime);
+    }
+    PendingScoreRequests.Add(MoveTemp(Request));
+}
+
+void URewindSubsystem::ProcessScoreRequests()
+{
+    if (PendingScoreRequests.IsEmpty()) return;
+
+    SCOPE_CYCLE_COUNTER(STAT_RewindProcessRequests);
+    CSV_SCOPED_TIMING_STAT(Blaster, RewindProcessRequests);
+
+    // Requests on the same victim go one after another, still in the order they arrived
+    Algo::StableSortBy(PendingScoreRequests,
+        [](const FScoreRequest& Request) { return Request.HitCharacters.IsEmpty() ? nullptr : Request.HitCharacters[0]; });
+
+    const float Time = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+    float MaxRewindDepth = 0.f;
+    FScoreRequestTypeTimes TypeTimes;
+
+    // Rewinding and the projectile path traces need the world, so they stay on the game thread
+    TArray<FRewindJob> Jobs;
+    Jobs.SetNum(PendingScoreRequests.Num());
+    for (int32 Index = 0; Index < PendingScoreRequests.Num(); ++Index)
+    {
+        const FScoreRequest& Request = PendingScoreRequests[Index];
+        if (IsValid(Request.Instigator))
+        {
+            FScopeCycleCounter TypeCycleCounter(GetScoreRequestStatId(Request.Type));
+            const double StartSeconds = FPlatformTime::Seconds();
+            Request.Instigator->PrepareScoreRequest(Request, Jobs[Index]);
+            TypeTimes.Add(Request.Type, FPlatformTime::Seconds() - StartSeconds);
+        }
+        MaxRewindDepth = FMath::Max(MaxRewindDepth, Time - Request.HitTime);
+    }
+    FrameCache.Reset();
+
+    // The jobs only hold copies of the rewound boxes, the analytic tests can run on the task graph
+    {
+        SCOPE_CYCLE_COUNTER(STAT_RewindSolveJobs);
+        CSV_SCOPED_TIMING_STAT(Blaster, RewindSolveJobs);
+        ParallelFor(
+            Jobs.Num(), [&Jobs](int32 Index) { BlasterRewindMath::SolveJob(Jobs[Index]); },
+            Jobs.Num() < MinJobsToParallelize ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+    }
+
+    int32 ConfirmedRequests = 0;
+    for (int32 Index = 0; Index < PendingScoreRequests.Num(); ++Index)
+    {
+        const FScoreRequest& Request = PendingScoreRequests[Index];
+        if (IsValid(Request.Instigator))
+        {
+            FScopeCycleCounter TypeCycleCounter(GetScoreRequestStatId(Request.Type));
+            const double StartSeconds = FPlatformTime::Seconds();
+            if (Request.Instigator->FinishScoreRequest(Request, Jobs[Index], DamageBatch))
+            {
+                ++ConfirmedRequests;
+            }
+            TypeTimes.Add(Request.Type, FPlatformTime::Seconds() - StartSeconds);
+        }
+    }
+
+    const int32 RejectedRequests = PendingScoreRequests.Num() - ConfirmedRequests;
+    INC_DWORD_STAT_BY(STAT_RewindScoreRequests, PendingScoreRequests.Num());
+    INC_DWORD_STAT_BY(STAT_RewindConfirmedRequests, ConfirmedRequests);
+    INC_DWORD_STAT_BY(STAT_RewindRejectedRequests, RejectedRequests);
+    SET_FLOAT_STAT(STAT_RewindMaxDepth, MaxRewindDepth * 1000.f);
+    CSV_CUSTOM_STAT(Blaster, RewindScoreRequests, PendingScoreRequests.Num(), ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(Blaster, RewindConfirmedRequests, ConfirmedRequests, ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(Blaster, RewindRejectedRequests, RejectedRequests, ECsvCustomStatOp::Accumulate);
+    CSV_CUSTOM_STAT(Blaster, RewindMaxDepthMs, MaxRewindDepth * 1000.f, ECsvCustomStatOp::Max);
+    TypeTimes.Report();
+
+    PendingScoreRequests.Reset();
+
+    ApplyDamageBatch();
+}
+
+void URewindSubsystem::ApplyDamageBatch()
+{
+    SCOPE_CYCLE_COUNTER(STAT_RewindApplyDamage);
+
+    for (const FConfirmedHit& Hit : DamageBatch.Hits)
+    {
+        if (!IsValid(Hit.HitCharacter) || !IsValid(Hit.DamageCauser)) continue;
+        UGameplayStatics::ApplyDamage(  //
+            Hit.HitCharacter,           //
+            Hit.Damage,                 //
+            Hit.InstigatorController,   //
+            Hit.DamageCauser,           //
+            UDamageType::StaticClass()  //
+        );
+    }
+
+    for (const FConfirmedExplosion& Explosion : DamageBatch.Explosions)
+    {
+        if (!IsValid(Explosion.DamageCauser)) continue;
+        UBlasterGameplayStatics::MakeRadialDamageWithFallOff(  //
+            Explosion.Result.OverlapCharactersMap,             //
+            Explosion.HitCharacters,                           //
+            Explosion.Result.Origin,                           //
+            Explosion.Damage,                                  //
+            Explosion.DamageInnerRadius,                       //
+            Explosion.DamageOuterRadius,                       //
+            Explosion.InstigatorController,                    //
+            Explosion.DamageCauser);
+    }
+
+    DamageBatch.Hits.Reset();
+    DamageBatch.Explosions.Reset();
+}
+
+FFramePackage URewindSubsystem::GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_RewindGetFrameToCheck);
+
+    const int32 TimeKey = GetTimeKey(HitTime);
+    const TPair<const ABlasterCharacter*, int32> Key(HitCharacter, TimeKey);
+    if (const FFramePackage* CachedFrame = FrameCache.Find(Key))
+    {
+        INC_DWORD_STAT(STAT_RewindFrameCacheHits);
+        return *CachedFrame;
+    }
+    return FrameCache.Add(Key, RewindFrame(HitCharacter, TimeKey * HitTimeQuantum));
+}
+
+bool URewindSubsystem::GetBoundsToCheck(const ABlasterCharacter* HitCharacter, float HitTime, FBox& OutBounds) const
+{
+    const int32 Index = Characters.IndexOfByKey(HitCharacter);
+    if (!HitCharacter || Index == INDEX_NONE || Histories[Index].IsEmpty()) return false;
+
+    // Same quantized time GetFrameToCheck rewinds to
+    const float TimeToCheck = GetTimeKey(HitTime) * HitTimeQuantum;
+    const FFrameHistory& History = Histories[Index];
+    if (History.GetOldestTime() > TimeToCheck) return false;
+
+    // The interpolated frame lies between the two bracketing frames, so it lies inside their union
+    const int32 YoungerIndex = History.UpperBound(TimeToCheck);
+    if (YoungerIndex == History.Num())
+    {
+        OutBounds = History.GetBounds(History.Num() - 1);
+    }
+    else
+    {
+        OutBounds = History.GetBounds(YoungerIndex);
+        if (YoungerIndex > 0)
+        {
+            OutBounds += History.GetBounds(YoungerIndex - 1);
+        }
+    }
+    OutBounds = OutBounds.ExpandBy(BoundsMargin);
+    return true;
+}
+
+FFramePackage URewindSubsystem::RewindFrame(ABlasterCharacter* HitCharacter, float HitTime) const
+{
+    const int32 Index = Characters.IndexOfByKey(HitCharacter);
+    if (!HitCharacter || Index == INDEX_NONE || Histories[Index].IsEmpty()) return FFramePackage();
+
+    // Frame package that we check to verify a hit
+    FFramePackage FrameToCheck;
+    // Frame history of the HitCharacter
+    const FFrameHistory& History = Histories[Index];
+    const float OldestHistoryTime = History.GetOldestTime();
+    const float NewestHistoryTime = History.GetNewestTime();
+    if (OldestHistoryTime > HitTime)
+    {
+        // too far back - too laggy to do SSR
+        return FFramePackage();
+    }
+    if (FMath::IsNearlyEqual(OldestHistoryTime, HitTime))
+    {
+        History.Decode(0, FrameToCheck);
+    }
+    else if (NewestHistoryTime <= HitTime)
+    {
+        History.Decode(History.Num() - 1, FrameToCheck);
+    }
+    else
+    {
+        // Binary search for the frames bracketing HitTime: OlderTime <= HitTime < YoungerTime
+        const int32 YoungerIndex = History.UpperBound(HitTime);
+        const int32 OlderIndex = YoungerIndex - 1;
+        if (HitTime <= History.GetEndTime(OlderIndex) || FMath::IsNearlyEqual(History.GetEndTime(OlderIndex), HitTime))
+        {
+            // The pose held still over HitTime
+            History.Decode(OlderIndex, FrameToCheck);
+        }
+        else
+        {
+            // interpolate frames between Younger and Older, from the last time the older pose was seen
+            FFramePackage Younger;
+            FFramePackage Older;
+            History.Decode(YoungerIndex, Younger);
+            History.Decode(OlderIndex, Older);
+            Older.Time = History.GetEndTime(OlderIndex);
+            FrameToCheck = InterpBetweenFrames(Older, Younger, HitTime);
+        }
+    }
+    FrameToCheck.Character = HitCharacter;
+    return FrameToCheck;
+}
+
+FFramePackage URewindSubsystem::InterpBetweenFrames(  //
+    const FFramePackage& OlderFrame,                  //
+    const FFramePackage& YoungerFrame,                //
+    float HitTime) const
+{
+    SCOPE_CYCLE_COUNTER(STAT_RewindInterpBetweenFrames);
+    INC_DWORD_STAT(STAT_RewindFramesInterpolated);
+    CSV_CUSTOM_STAT(Blaster, RewindFramesInterpolated, 1, ECsvCustomStatOp::Accumulate);
+
+    const float Distance = YoungerFrame.Time - OlderFrame.Time;
+    const float InterpFraction = FMath::Clamp((HitTime - OlderFrame.Time) / Distance, 0.f, 1.f);
+
+    FFramePackage InterpFramePackage;
+    InterpFramePackage.Time = HitTime;
+    InterpFramePackage.Bounds = OlderFrame.Bounds + YoungerFrame.Bounds;
+
+    // Interpolate hit boxes
+    for (int32 Slot = 0; Slot < HitBox::Num; ++Slot)
+    {
+        InterpFramePackage.Locations[Slot] = FMath::Lerp(OlderFrame.Locations[Slot], YoungerFrame.Locations[Slot], InterpFraction);
+        InterpFramePackage.Rotations[Slot] = FQuat::Slerp(OlderFrame.Rotations[Slot], YoungerFrame.Rotations[Slot], InterpFraction);
+        InterpFramePackage.BoxExtents[Slot] = YoungerFrame.BoxExtents[Slot];
+    }
+    return InterpFramePackage;
+}
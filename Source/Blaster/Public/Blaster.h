@@ -3,6 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// stat Blaster
+DECLARE_STATS_GROUP(TEXT("Blaster"), STATGROUP_Blaster, STATCAT_Advanced);
+
+CSV_DECLARE_CATEGORY_EXTERN(Blaster);
+
+DECLARE_LOG_CATEGORY_EXTERN(LogBlaster, Log, All);
 
 #define ECC_SkeletalMesh ECollisionChannel::ECC_GameTraceChannel1
 #define ECC_IK_Visibility ECollisionChannel::ECC_GameTraceChannel2
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
+#include "Engine/NetSerialization.h"
+#include "WorldCollision.h"
 #include "BlasterHUD.h"
 #include "CarryItemTypes.h"
 #include "CombatState.h"
@@ -18,6 +20,87 @@ class ABlasterHUD;
 class AProjectile;
 class ACarryItem;
 
+/**
+ * One shot as it crosses the wire: the muzzle relative to the shooter's replicated location, the aim as an
+ * octahedral packed direction and a distance, the weapon it was fired with and how long before the send it was
+ * due. About a hundred bits. Shotgun shots send their absolute quantized muzzle and aim instead, the server rolls
+ * the client's pellets from exactly them
+ */
+USTRUCT()
+struct FShotRecord
+{
+    GENERATED_USTRUCT_BODY()
+
+    static FShotRecord Make(const FVector& ActorLocation, const FVector& Origin, const FVector& Target, EWeaponType WeaponType);
+
+    FORCEINLINE bool IsShotgun() const { return WeaponType == EWeaponType::EWT_Shotgun; };
+    FORCEINLINE FVector GetOrigin(const FVector& ActorLocation) const
+    {
+        return IsShotgun() ? ScatterOrigin : ActorLocation + OriginOffset;
+    };
+    FORCEINLINE FVector GetTarget(const FVector& ActorLocation) const
+    {
+        return IsShotgun() ? ScatterTarget : GetOrigin(ActorLocation) + AimDirection * AimDistance;
+    };
+
+    UPROPERTY()
+    FVector OriginOffset = FVector::ZeroVector;
+
+    // Unit vector from the muzzle to the target
+    UPROPERTY()
+    FVector AimDirection = FVector::ForwardVector;
+
+    UPROPERTY()
+    float AimDistance = 0.f;
+
+    UPROPERTY()
+    EWeaponType WeaponType = EWeaponType::EWS_MAX;
+
+    // Seconds the shot was due before it was sent, in milliseconds on the wire
+    UPROPERTY()
+    float TimeOffset = 0.f;
+
+    // Shotgun only, the pellets are rolled from it
+    UPROPERTY()
+    int32 ScatterSeed = 0;
+
+    // Shotgun only, the muzzle and aim as AShotgun::QuantizeScatterInputs rounded them
+    UPROPERTY()
+    FVector_NetQuantize ScatterOrigin = FVector::ZeroVector;
+
+    UPROPERTY()
+    FVector_NetQuantize100 ScatterTarget = FVector::ZeroVector;
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FShotRecord> : public TStructOpsTypeTraitsBase2<FShotRecord>
+{
+    enum
+    {
+        WithNetSerializer = true
+    };
+};
+
+/**
+ * Shots of the equipped weapon as simulated proxies see them. Replicated instead of a multicast per shot,
+ * shots between two net updates are coalesced into the counter and replayed with the latest aim
+ */
+USTRUCT()
+struct FFireState
+{
+    GENERATED_USTRUCT_BODY()
+
+    // Wraps around, proxies play the difference to the previous value
+    UPROPERTY()
+    uint8 ShotCounter = 0;
+
+    // Last shot, relative to the shooter
+    UPROPERTY()
+    FShotRecord Shot;
+};
+
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class BLASTER_API UCombatComponent : public UActorComponent
 {
@@ -94,21 +177,26 @@ protected:
 
     int32 GetAmountToReload();
 
+    // Every shot the client fired in a frame, in one send. Shots faster than the weapon fires or fired with another
+    // weapon are dropped one by one. Only the server-to-proxy direction is a fire state: the server spawns the
+    // authoritative projectiles and traces from each shot's own aim and time, a start/stop state with a throttled
+    // aim stream couldn't give it those, so the client keeps sending compact shot records, batched per frame
     UFUNCTION(Server, Reliable, WithValidation)
-    void ServerFire(const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation, float FireDelay);
-
-    UFUNCTION(NetMulticast, Reliable)
-    void MulticastFire(const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation);
+    void ServerFire(const TArray<FShotRecord>& Shots);
 
-    UFUNCTION(Server, Reliable, WithValidation)
-    void ServerShotgunFire(
-        const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation, float FireDelay);
+    UFUNCTION()
+    void OnRep_FireState();
 
-    UFUNCTION(NetMulticast, Reliable)
-    void MulticastShotgunFire(const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation);
+    // Plays one of the shots a fire state update brought and schedules the next one
+    void PlayProxyShot();
 
     void TraceUnderCrosshairs(FHitResult& TraceHitResult);
 
+    // Reads the async traces issued last frame and issues this frame's, the game thread never waits on them
+    void UpdateAsyncTraces();
+    bool GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd);
+    void HandleCrosshairHit(FHitResult& TraceHitResult, const FVector& TraceEnd);
+
     void SetHUDCrosshairs(float DeltaTime);
 
     void ThrowGrenade();
@@ -141,13 +229,22 @@ private:
     float GetCrosshairsSpread(float DeltaTime);
     void InterpFOV(float DeltaTime);
     void Fire();
+
+    // Fires one shot due at ShotTime, its record waits in PendingShots until SendPendingShots
+    bool FireShot(double ShotTime);
+
+    // Fires every automatic shot due since last frame, each on its own due time rather than on the frame's
+    void UpdateFireSchedule();
+    void SendPendingShots();
+
+    // Server: drops a shot the client predicted, its weapon gets the round back on the client
+    void RejectShot(const FShotRecord& Shot);
     void FireProjectileWeapon();
     void FireHitScanWeapon();
     void FireShotgun();
     void LocalFire(const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation);
-    void ShotgunLocalFire(const TArray<FVector_NetQuantize100>& TraceHitTargets, const FVector_NetQuantize100& SocketLocation);
-    void StartFireTimer();
-    void FireTimerFinished();
+    void ShotgunLocalFire(const FVector_NetQuantize100& TraceHitTarget, const FVector_NetQuantize100& SocketLocation, int32 ScatterSeed);
+    FShotRecord MakeShotRecord(const FVector& SocketLocation, const FVector& TraceHitTarget) const;
     bool CanFire();
     void InitializeCarriedAmmo();
     bool CanReload();
@@ -230,6 +327,21 @@ private:
 
     FHUDPackage HUDPackage;
 
+    /**
+     * Async traces
+     */
+    FTraceHandle CrosshairTraceHandle;
+    FTraceHandle WallTraceHandle;
+    float CrosshairTraceTime = -1.f;
+    float WallTraceTime = -1.f;
+
+    // Distance from the character to the wall in front of the aim, max float if there is none
+    float WallTraceDistance = TNumericLimits<float>::Max();
+
+    // Older results are traced again synchronously, only happens when the async traces stop
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    float TraceResultTimeToLive = 0.1f;
+
     /**
      * Aiming and FOV
      */
@@ -244,9 +356,42 @@ private:
     UPROPERTY(EditAnywhere, Category = "Combat")
     float ZoomInterpSpeed = 20.f;
 
-    FTimerHandle FireTimer;
     bool bCanFire = true;
 
+    // Fire schedule in world time, the next shot is due a fire delay after the previous one was due
+    double NextShotTime = 0.0;
+    TArray<FShotRecord> PendingShots;
+
+    // Seconds the shot being fired was due before this frame
+    float ShotTimeOffset = 0.f;
+
+    // Server: fire rate of a remote shooter, measured as its shots arrive. Every fire delay of the weapon adds a shot of
+    // credit, up to one shot plus FireJitterAllowance worth of shots. A newly equipped weapon starts with full credit
+    float ShotCredit = 0.f;
+    double ShotCreditTime = 0.0;
+    TWeakObjectPtr<AWeapon> ShotCreditWeapon;
+
+    // Seconds of network jitter that can bunch up shots without them being dropped
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    float FireJitterAllowance = 0.1f;
+
+    // Shots a single frame can fire, a hitch doesn't turn into a burst
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    int32 MaxShotsPerFrame = 4;
+
+    UPROPERTY(ReplicatedUsing = OnRep_FireState)
+    FFireState FireState;
+
+    // Proxies: counter of the last fire state seen and the shots still to play, one every FireDelay
+    uint8 LastShotCounter = 0;
+    bool bFireStateReceived = false;
+    int32 ProxyShotsToPlay = 0;
+    FTimerHandle ProxyShotTimer;
+
+    // Shots a single fire state update can replay, a proxy that fell behind doesn't burst
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    int32 MaxProxyShotsPerUpdate = 4;
+
     // Carried ammo for the currently-equipped weapon
     UPROPERTY(ReplicatedUsing = OnRep_CarriedAmmo)
     int32 CarriedAmmo;
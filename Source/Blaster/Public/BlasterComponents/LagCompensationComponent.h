@@ -5,73 +5,199 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "Engine/HitResult.h"
+#include "HitBoxTypes.h"
 #include "LagCompensationComponent.generated.h"
 
 class ABlasterCharacter;
 class ABlasterPlayerController;
 class AWeapon;
+class URewindSubsystem;
+class AController;
+struct FRewindJob;
 
 USTRUCT(BlueprintType)
-struct FBoxInformation
+struct FFramePackage
 {
     GENERATED_USTRUCT_BODY()
 
-    UPROPERTY()
-    FVector Location;
+    UPROPERTY();
+    float Time;
 
-    UPROPERTY()
-    FRotator Rotation;
+    // Hit box transforms, indexed by HitBox::Slot
+    FVector Locations[HitBox::Num];
+    FQuat Rotations[HitBox::Num];
+    FVector BoxExtents[HitBox::Num];
 
-    UPROPERTY()
-    FVector BoxExtent;
+    // Encloses every hit box of the frame, rewind queries cull characters with it before any box is tested
+    FBox Bounds = FBox(ForceInit);
+
+    UPROPERTY();
+    ABlasterCharacter* Character;
 };
 
 USTRUCT(BlueprintType)
-struct FFramePackage
+struct FExplosionProjectileServerSideRewindResult
 {
     GENERATED_USTRUCT_BODY()
 
-    UPROPERTY();
-    float Time;
+    UPROPERTY()
+    FVector Origin;
 
     UPROPERTY()
-    TMap<FName, FBoxInformation> HitBoxInfo;
+    TMap<AActor*, FHitResult> OverlapCharactersMap;
+};
 
-    UPROPERTY();
-    ABlasterCharacter* Character;
+UENUM()
+enum class EScoreRequestType : uint8
+{
+    HitScan,
+    Projectile,
+    ExplosionProjectile,
+    Shotgun
 };
 
-USTRUCT(BlueprintType)
-struct FServerSideRewindResult
+/**
+ * Hit a client claims, sent to the server in bundles over an unreliable RPC.
+ * Only the fields of the claim's type are serialized.
+ */
+USTRUCT()
+struct FHitClaim
 {
     GENERATED_USTRUCT_BODY()
 
+    // Wraps around, compared with IsSequenceNewer
     UPROPERTY()
-    bool bHitConfirmed;
+    uint16 Sequence = 0;
 
     UPROPERTY()
-    float DamageModifier;
+    EScoreRequestType Type = EScoreRequestType::HitScan;
+
+    // One character for hit scan and projectile claims
+    UPROPERTY()
+    TArray<ABlasterCharacter*> HitCharacters;
+
+    UPROPERTY()
+    FVector_NetQuantize TraceStart;
+
+    // One location for hit scan claims, the aim for the shotgun
+    UPROPERTY()
+    TArray<FVector_NetQuantize100> HitLocations;
+
+    // The server regenerates the shotgun's pellets from the aim and this seed
+    UPROPERTY()
+    int32 ScatterSeed = 0;
+
+    UPROPERTY()
+    FVector_NetQuantize100 InitialVelocity;
+
+    UPROPERTY()
+    float GravityScale = 0.f;
+
+    UPROPERTY()
+    float HitTime = 0.f;
+
+    UPROPERTY()
+    float Damage = 0.f;
+
+    UPROPERTY()
+    float DamageInnerRadius = 0.f;
+
+    UPROPERTY()
+    float DamageOuterRadius = 0.f;
+
+    UPROPERTY()
+    AWeapon* DamageCauser = nullptr;
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
 };
 
-USTRUCT(BlueprintType)
-struct FShotgunServerSideRewindResult
+template <>
+struct TStructOpsTypeTraits<FHitClaim> : public TStructOpsTypeTraitsBase2<FHitClaim>
+{
+    enum
+    {
+        WithNetSerializer = true
+    };
+};
+
+// Claim waiting on the owning client for the server's acknowledgement
+USTRUCT()
+struct FPendingHitClaim
 {
     GENERATED_USTRUCT_BODY()
 
     UPROPERTY()
-    TMap<ABlasterCharacter*, float> Shots;
+    FHitClaim Claim;
+
+    float LastSendTime = 0.f;
+    int32 SendCount = 0;
 };
 
-USTRUCT(BlueprintType)
-struct FExplosionProjectileServerSideRewindResult
+/**
+ * Sequences the server has received, the newest one and a bit for each of the 32 before it.
+ * Sent back to the client as the acknowledgement
+ */
+struct FHitClaimAckWindow
 {
-    GENERATED_USTRUCT_BODY()
+    // False if the sequence was already received or is too old to tell
+    bool MarkReceived(uint16 Sequence);
 
-    UPROPERTY()
-    FVector Origin;
+    bool IsAcked(uint16 Sequence) const;
 
-    UPROPERTY()
-    TMap<AActor*, FHitResult> OverlapCharactersMap;
+    uint16 Latest = 0;
+    uint32 Bits = 0;
+    bool bReceivedAny = false;
+};
+
+/**
+ * Score request received from a client, queued until the rewind subsystem processes the tick's batch.
+ * Requests are received and processed within the same world tick, before garbage collection can run.
+ */
+struct FScoreRequest
+{
+    EScoreRequestType Type = EScoreRequestType::HitScan;
+    ULagCompensationComponent* Instigator = nullptr;
+
+    // One character for hit scan and projectile requests
+    TArray<ABlasterCharacter*> HitCharacters;
+    FVector_NetQuantize TraceStart;
+
+    // One location for hit scan requests, a location per pellet for the shotgun
+    TArray<FVector_NetQuantize100> HitLocations;
+    FVector_NetQuantize100 InitialVelocity;
+
+    float GravityScale = 0.f;
+    float HitTime = 0.f;
+    float Damage = 0.f;
+    float DamageInnerRadius = 0.f;
+    float DamageOuterRadius = 0.f;
+    AWeapon* DamageCauser = nullptr;
+};
+
+struct FConfirmedHit
+{
+    ABlasterCharacter* HitCharacter = nullptr;
+    float Damage = 0.f;
+    AController* InstigatorController = nullptr;
+    AWeapon* DamageCauser = nullptr;
+};
+
+struct FConfirmedExplosion
+{
+    FExplosionProjectileServerSideRewindResult Result;
+    TArray<AActor*> HitCharacters;
+    float Damage = 0.f;
+    float DamageInnerRadius = 0.f;
+    float DamageOuterRadius = 0.f;
+    AController* InstigatorController = nullptr;
+    AWeapon* DamageCauser = nullptr;
+};
+
+// Damage confirmed during one tick, applied once every request of the tick is processed
+struct FRewindDamageBatch
+{
+    TArray<FConfirmedHit> Hits;
+    TArray<FConfirmedExplosion> Explosions;
 };
 
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
@@ -82,35 +208,43 @@ class BLASTER_API ULagCompensationComponent : public UActorComponent
 public:
     ULagCompensationComponent();
     friend class ABlasterCharacter;
-    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
     void ShowFramePackage(const FFramePackage& Package, const FColor& Color);
 
     /**
-     * HitScan
+     * A queued request is confirmed in three steps by the rewind subsystem:
+     * prepare on the game thread, solve the job on a worker thread, finish on the game thread
      */
-    UFUNCTION(Server, Reliable, WithValidation)
-    void ServerScoreRequest(ABlasterCharacter* HitCharacter,  //
-        const FVector_NetQuantize& TraceStart,                //
-        const FVector_NetQuantize100& HitLocation,            //
-        float HitTime,
-        float Damage,          //
-        AWeapon* DamageCauser  //
-    );
+
+    // Rewinds the candidates and traces projectile paths against the world
+    void PrepareScoreRequest(const FScoreRequest& Request, FRewindJob& OutJob);
+
+    // Checks occlusion and damage modifiers of the solved job, the damage is added to OutBatch. False if nothing was confirmed
+    bool FinishScoreRequest(const FScoreRequest& Request, const FRewindJob& Job, FRewindDamageBatch& OutBatch);
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
     /**
-     * Projectile
+     * Hit claims of the owning client. They are queued and flushed together once per frame,
+     * on the server they go straight to the rewind subsystem
      */
 
-    UFUNCTION(Server, Reliable, WithValidation)
-    void ProjectileServerScoreRequest(ABlasterCharacter* HitCharacter,  //
-        const FVector_NetQuantize& TraceStart,                          //
-        const FVector_NetQuantize100& InitialVelocity,                  //
-        float GravityScale,                                             //
-        float HitTime,                                                  //
-        float Damage,                                                   //
-        AWeapon* DamageCauser                                           //
-    );
+    // HitScan
+    void ScoreRequest(ABlasterCharacter* HitCharacter,  //
+        const FVector_NetQuantize& TraceStart,          //
+        const FVector_NetQuantize100& HitLocation,      //
+        float HitTime,                                  //
+        float Damage,                                   //
+        AWeapon* DamageCauser);
+
+    // Projectile
+    void ProjectileScoreRequest(ABlasterCharacter* HitCharacter,  //
+        const FVector_NetQuantize& TraceStart,                    //
+        const FVector_NetQuantize100& InitialVelocity,            //
+        float GravityScale,                                       //
+        float HitTime,                                            //
+        float Damage,                                             //
+        AWeapon* DamageCauser);
 
     /**
      * Explosion projectile
@@ -118,9 +252,7 @@ public:
      * Grenade Launcher
      * Grenades
      */
-
-    UFUNCTION(Server, Reliable, WithValidation)
-    void ExplosionProjectileServerScoreRequest(           //
+    void ExplosionProjectileScoreRequest(                 //
         const TArray<ABlasterCharacter*>& HitCharacters,  //
         const FVector_NetQuantize& TraceStart,            //
         const FVector_NetQuantize100& InitialVelocity,    //
@@ -128,104 +260,52 @@ public:
         float Damage,                                     //
         float DamageInnerRadius,                          //
         float DamageOuterRadius,                          //
-        AWeapon* DamageCauser,
-        float HitTime  //
-    );
+        AWeapon* DamageCauser,                            //
+        float HitTime);
 
-    /**
-     * Shotgun
-     */
-    UFUNCTION(Server, Reliable, WithValidation)
-    void ShotgunServerScoreRequest(                          //
-        const TArray<ABlasterCharacter*>& HitCharacters,     //
-        const FVector_NetQuantize& TraceStart,               //
-        const TArray<FVector_NetQuantize100>& HitLocations,  //
-        float HitTime,                                       //
-        float Damage,                                        //
-        AWeapon* DamageCauser                                //
-    );
+    // Shotgun
+    void ShotgunScoreRequest(                             //
+        const TArray<ABlasterCharacter*>& HitCharacters,  //
+        const FVector_NetQuantize& TraceStart,            //
+        const FVector_NetQuantize100& HitTarget,          //
+        int32 ScatterSeed,                                //
+        float HitTime,                                    //
+        float Damage,                                     //
+        AWeapon* DamageCauser);
 
 protected:
     virtual void BeginPlay() override;
-    void SaveFramePackage(FFramePackage& Package);
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-    FFramePackage InterpBetweenFrames(      //
-        const FFramePackage& OlderFrame,    //
-        const FFramePackage& YoungerFrame,  //
-        float HitTime);
+    UFUNCTION(Server, Unreliable, WithValidation)
+    void ServerHitClaims(const TArray<FHitClaim>& Claims);
 
-    void CacheBoxPositions(ABlasterCharacter* HitCharacter, FFramePackage& OutFramePackage);
-    void MoveBoxes(ABlasterCharacter* HitCharacter, const FFramePackage& Package);
-    void ResetHitBoxes(ABlasterCharacter* HitCharacter, const FFramePackage& Package);
-    void EnableCharacterMeshCollision(ABlasterCharacter* HitCharacter, ECollisionEnabled::Type CollisionEnabled);
-    void SaveFramePackage();
-    FFramePackage GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime);
+    UFUNCTION(Client, Unreliable)
+    void ClientAckHitClaims(uint16 Latest, uint32 Bits);
 
-    /**
-     * HitScan
-     */
-    FServerSideRewindResult ServerSideRewind(ABlasterCharacter* HitCharacter,  //
-        const FVector_NetQuantize& TraceStart,                                 //
-        const FVector_NetQuantize100& HitLocation,                             //
-        float HitTime);
-
-    FServerSideRewindResult ConfirmHit(const FFramePackage& Package,  //
-        ABlasterCharacter* HitCharacter,                              //
-        const FVector_NetQuantize& TraceStart,                        //
-        const FVector_NetQuantize100& HitLocation);
-
-    /**
-     * Projectile
-     */
+    void CacheBoxPositions(ABlasterCharacter* HitCharacter, FFramePackage& OutFramePackage);
 
-    FServerSideRewindResult ProjectileServerSideRewind(ABlasterCharacter* HitCharacter,  //
-        const FVector_NetQuantize& TraceStart,                                           //
-        const FVector_NetQuantize100& InitialVelocity,                                   //
-        float GravityScale,                                                              //
-        float HitTime);
+    // Rewound boxes are tested analytically, the world is only traced to check that nothing blocks the shot
+    bool IsOccluded(const FVector& Start, const FVector& End, const FCollisionQueryParams& Params) const;
 
-    FServerSideRewindResult ProjectileConfirmHit(const FFramePackage& Package,  //
-        ABlasterCharacter* HitCharacter,                                        //
-        const FVector_NetQuantize& TraceStart,                                  //
-        const FVector_NetQuantize100& InitialVelocity,                          //
-        float GravityScale,                                                     //
-        float HitTime);
+    // Hit boxes are recorded by the rewind subsystem, this asks it for the frame at HitTime
+    FFramePackage GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime);
 
-    /**
-     * Explosion projectiles
-     */
+    // Projectile path against world geometry only, the rewound boxes are swept along its segments by the job
+    void TraceProjectilePath(const FScoreRequest& Request, FRewindJob& OutJob);
 
-    FExplosionProjectileServerSideRewindResult ExplosionProjectileServerSideRewind(  //
-        const TArray<ABlasterCharacter*>& HitCharacters,                             //
-        const FVector_NetQuantize& TraceStart,                                       //
-        const FVector_NetQuantize100& InitialVelocity,                               //
-        float GravityScale,                                                          //
-        float DamageOuterRadius,                                                     //
-        float HitTime);
+    // False when the character's recorded bounds around HitTime are out of reach of every shot of the job
+    bool IsInReach(ABlasterCharacter* HitCharacter, float HitTime, const FRewindJob& Job) const;
 
-    FExplosionProjectileServerSideRewindResult ExplosionProjectileConfirmHit(  //
-        const TArray<FFramePackage>& FramePackages,                            //
-        const FVector_NetQuantize& TraceStart,                                 //
-        const FVector_NetQuantize100& InitialVelocity,                         //
-        float GravityScale,                                                    //
-        float DamageOuterRadius,                                               //
-        float HitTime);
+private:
+    void QueueHitClaim(FHitClaim&& Claim);
+    void FlushHitClaims();
 
-    /**
-     * Shotgun
-     */
-    FShotgunServerSideRewindResult ShotgunServerSideRewind(  //
-        const TArray<ABlasterCharacter*>& HitCharacters,     //
-        const FVector_NetQuantize& TraceStart,               //
-        const TArray<FVector_NetQuantize100>& HitLocations,  //
-        float HitTime);                                      //
+    // Same checks the per-shot score RPCs did, an invalid claim is dropped
+    bool IsHitClaimValid(const FHitClaim& Claim) const;
 
-    FShotgunServerSideRewindResult ShotgunConfirmHit(  //
-        const TArray<FFramePackage>& FramePackages,    //
-        const FVector_NetQuantize& TraceStart,         //
-        const TArray<FVector_NetQuantize100>& HitLocations);
+    void QueueScoreRequest(const FHitClaim& Claim);
 
-private:
     bool IsCharacterValid();
 
     UPROPERTY()
@@ -234,10 +314,28 @@ private:
     UPROPERTY()
     ABlasterPlayerController* BlasterPlayerController;
 
-    TDoubleLinkedList<FFramePackage> FrameHistory;
-
-    UPROPERTY(EditAnywhere)
-    float MaxRecordTime = 4.f;
+    URewindSubsystem* GetRewindSubsystem() const;
+    float GetMaxRecordTime() const;
 
     FCriticalSection CriticalSection;
+
+    // Owning client: claims not acknowledged yet, oldest first
+    UPROPERTY()
+    TArray<FPendingHitClaim> PendingHitClaims;
+
+    uint16 NextHitClaimSequence = 0;
+
+    // Server: claims received from the owning client
+    FHitClaimAckWindow ReceivedHitClaims;
+
+    // A claim is sent again if it isn't acknowledged after this long
+    UPROPERTY(EditDefaultsOnly, Category = "Hit Claims")
+    float HitClaimResendInterval = 0.1f;
+
+    // Claims are dropped after this many sends, the server would reject them as too old soon anyway
+    UPROPERTY(EditDefaultsOnly, Category = "Hit Claims")
+    int32 MaxHitClaimSends = 4;
+
+    UPROPERTY(EditDefaultsOnly, Category = "Hit Claims")
+    int32 MaxHitClaimsPerBundle = 16;
 };
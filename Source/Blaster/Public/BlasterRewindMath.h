@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HitBoxTypes.h"
+
+struct FFramePackage;
+
+/**
+ * Hit boxes of a single frame package in a SIMD friendly layout: one float per box for every component,
+ * padded to whole 4-wide packs. Positions are stored relative to Origin to keep float precision on big maps.
+ */
+struct FRewindBoxes
+{
+    static constexpr int32 NumPacks = (HitBox::Num + 3) / 4;
+    static constexpr int32 NumLanes = NumPacks * 4;
+
+    void Build(const FFramePackage& Package, const FVector& InOrigin);
+
+    FVector Origin = FVector::ZeroVector;
+
+    // Bit per slot, set when the box exists on the character
+    uint32 ValidSlots = 0;
+
+    alignas(16) float CenterX[NumLanes];
+    alignas(16) float CenterY[NumLanes];
+    alignas(16) float CenterZ[NumLanes];
+
+    alignas(16) float QuatX[NumLanes];
+    alignas(16) float QuatY[NumLanes];
+    alignas(16) float QuatZ[NumLanes];
+    alignas(16) float QuatW[NumLanes];
+
+    alignas(16) float ExtentX[NumLanes];
+    alignas(16) float ExtentY[NumLanes];
+    alignas(16) float ExtentZ[NumLanes];
+};
+
+struct FRewindSegment
+{
+    FVector Start = FVector::ZeroVector;
+    FVector End = FVector::ZeroVector;
+};
+
+struct FRewindShotHit
+{
+    // Index into FRewindJob::Candidates, INDEX_NONE when the shot missed
+    int32 CandidateIndex = INDEX_NONE;
+    int32 Slot = INDEX_NONE;
+    FVector ImpactPoint = FVector::ZeroVector;
+};
+
+struct FRewindOverlap
+{
+    int32 Slot = INDEX_NONE;
+    FVector ClosestPoint = FVector::ZeroVector;
+};
+
+/**
+ * Analytic part of one score request. It holds its own copies of the rewound boxes and touches no UObject,
+ * so it is filled on the game thread, solved on a worker thread and read back on the game thread.
+ */
+struct FRewindJob
+{
+    // Rewound boxes of every candidate, in the order of the request's hit characters
+    TArray<FRewindBoxes> Candidates;
+
+    // Hit scan shots and shotgun pellets are independent segments, a projectile path is one chain of segments
+    TArray<FRewindSegment> Segments;
+    bool bSegmentsArePath = false;
+    float SweepRadius = 0.f;
+
+    // Explosions overlap the candidates from the first box hit on the path, or from the path's world hit
+    float OverlapRadius = 0.f;
+    bool bPathHitWorld = false;
+    FVector PathWorldHit = FVector::ZeroVector;
+
+    // One hit per segment, a single one for a path
+    TArray<FRewindShotHit> ShotHits;
+
+    bool bExploded = false;
+    FVector ExplosionOrigin = FVector::ZeroVector;
+
+    // One overlap per candidate
+    TArray<FRewindOverlap> Overlaps;
+};
+
+/**
+ * Analytic hit tests against rewound hit boxes. Nothing here touches the physics scene.
+ */
+class BlasterRewindMath
+{
+public:
+    /**
+     * Sweeps a sphere of Radius from Start to End through the boxes, Radius 0 is a plain segment.
+     * The sphere is approximated by the box inflated by Radius, which is slightly generous on the box corners.
+     * Returns the slot of the first box entered or INDEX_NONE, OutHitFraction is the entry point along the segment in [0, 1]
+     */
+    static int32 SweepBoxes(const FRewindBoxes& Boxes, const FVector& Start, const FVector& End, float Radius, float& OutHitFraction);
+
+    /**
+     * Returns the slot of the box nearest to Center among the ones the sphere overlaps or INDEX_NONE,
+     * OutClosestPoint is the point of that box closest to Center
+     */
+    static int32 OverlapBoxes(const FRewindBoxes& Boxes, const FVector& Center, float Radius, FVector& OutClosestPoint);
+
+    // Nearest box of all candidates the segment passes through
+    static FRewindShotHit SweepCandidates(TArrayView<const FRewindBoxes> Candidates, const FRewindSegment& Segment, float Radius);
+
+    // Thread safe, only reads and writes the job
+    static void SolveJob(FRewindJob& Job);
+
+    // Axis aligned box around the oriented hit boxes of the package
+    static FBox ComputeBounds(const FFramePackage& Package);
+
+    // True if any segment passes within Radius of the box
+    static bool SegmentsTouchBounds(TArrayView<const FRewindSegment> Segments, const FBox& Bounds, float Radius);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace HitBox
+{
+    // Stable slots of the server-side rewind hit boxes. Frame packages store the box data in this order
+    enum Slot : int32
+    {
+        Head,
+        Pelvis,
+        Spine02,
+        Spine03,
+        UpperArmL,
+        UpperArmR,
+        LowerArmL,
+        LowerArmR,
+        HandL,
+        HandR,
+        Backpack,
+        BlanketL,
+        BlanketR,
+        ThighL,
+        ThighR,
+        CalfL,
+        CalfR,
+        FootL,
+        FootR,
+
+        Num
+    };
+
+    // Bones the hit boxes were first attached to, also the names of the character's legacy box components
+    inline const TCHAR* GetDefaultBoneName(int32 Slot)
+    {
+        static const TCHAR* const BoneNames[Num] = {
+            TEXT("head"),
+            TEXT("pelvis"),
+            TEXT("spine_02"),
+            TEXT("spine_03"),
+            TEXT("upperarm_l"),
+            TEXT("upperarm_r"),
+            TEXT("lowerarm_l"),
+            TEXT("lowerarm_r"),
+            TEXT("hand_l"),
+            TEXT("hand_r"),
+            TEXT("backpack"),
+            TEXT("blanket_l"),
+            TEXT("blanket_r"),
+            TEXT("thigh_l"),
+            TEXT("thigh_r"),
+            TEXT("calf_l"),
+            TEXT("calf_r"),
+            TEXT("foot_l"),
+            TEXT("foot_r"),
+        };
+        return Slot >= 0 && Slot < Num ? BoneNames[Slot] : TEXT("");
+    }
+}
@@ -32,9 +32,12 @@ class UStaticMeshComponent;
 class UNiagaraComponent;
 class UNiagaraSystem;
 class UMaterialInterface;
+class UHitBoxSet;
 class UBoxComponent;
 class UBlasterAnimInstance;
 class UPhysicalMaterial;
+struct FQueuedDamage;
+struct FFramePackage;
 class ABlasterGameMode;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnLeftGame);
@@ -58,7 +61,7 @@ public:
     virtual void PostInitializeComponents() override;
 
     void PlayFireMontage(bool bAiming);
-    void PlayHitReactMontage(AActor* DamageCauser);
+    void PlayHitReactMontage(const FVector& DamageCauserLocation);
     void PlayElimMontage();
     void PlayThrowGrenadeMontage();
     void PlayReloadMontage();
@@ -66,9 +69,13 @@ public:
     void PlayMontage(UAnimMontage* Montage, FName SectionName = NAME_None);
     void StopAllMontages();
 
+    // Queues the damage event, the damage queue applies the frame's damage at once
     UFUNCTION()
     void ReceiveDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
 
+    // Damage of a frame, one entry per attacker
+    void ApplyFrameDamage(TArrayView<const FQueuedDamage> Attackers);
+
     virtual void OnRep_ReplicatedMovement() override;
 
     void Elim(bool bPlayerLeftGame);
@@ -125,8 +132,21 @@ public:
     UPROPERTY(EditAnywhere, Category = "Movement")
     float AimWalkSpeed = 450.f;
 
-    UPROPERTY()
-    TMap<FName, UBoxComponent*> HitCollisionBoxes;
+    // Server-side rewind hit boxes, posed from the mesh only when the rewind needs them. Unset, they are migrated
+    // from the legacy box components
+    UPROPERTY(EditDefaultsOnly, Category = "Server Side Rewind")
+    UHitBoxSet* HitBoxSet;
+
+    // True if the hit box in HitBox::Slot is defined and its bone exists on the mesh
+    bool HasHitBox(int32 Slot) const;
+
+    // Unscaled half size, zero without the box
+    FVector GetHitBoxExtent(int32 Slot) const;
+
+    FName GetHitBoxBoneName(int32 Slot) const;
+
+    // Hit box transforms and extents of the current pose, missing boxes are left zero sized
+    void CaptureHitBoxes(FFramePackage& OutPackage) const;
 
     bool bFinishSwapping = true;
 
@@ -146,6 +166,12 @@ public:
     UPROPERTY(EditAnywhere, Category = "Player Stats")
     TMap<UPhysicalMaterial*, float> DamageModifiers;
 
+    // Damage modifier of the hit material, false if hits on it deal no damage
+    bool GetDamageModifier(UPhysicalMaterial* PhysMat, float& OutDamageModifier) const;
+
+    // Damage modifier of the physical material on the hit box in HitBox::Slot, false if it has none
+    bool GetHitBoxDamageModifier(int32 Slot, float& OutDamageModifier) const;
+
     void SetTeamColor(ETeam Team);
 
 protected:
@@ -213,7 +239,10 @@ protected:
     UPROPERTY(Replicated, VisibleInstanceOnly)
     bool bGameplayDisabled = false;
 
-    /** Hit boxes used for server-side rewind */
+    /**
+     * Hit boxes the character blueprint was tuned with, kept until a HitBoxSet is assigned. They are never
+     * registered, a character without a HitBoxSet builds its hit boxes from their settings
+     */
     UPROPERTY(EditAnywhere)
     UBoxComponent* head;
 
@@ -272,6 +301,19 @@ protected:
     UBoxComponent* foot_r;
 
 private:
+    // Mesh bone of each hit box, INDEX_NONE when missing
+    TArray<int32> HitBoxBoneIndices;
+
+    // Built from the legacy box components when HitBoxSet is unset
+    UPROPERTY(Transient)
+    UHitBoxSet* MigratedHitBoxSet;
+
+    void CacheHitBoxBones();
+    void MigrateLegacyHitBoxes();
+
+    // HitBoxSet, the migrated set without one, or the class defaults as a last resort
+    const UHitBoxSet* GetHitBoxSet() const;
+
     UFUNCTION()
     void OnRep_OverlappingCarryItem(ACarryItem* LastCarryItem);
 
@@ -290,8 +332,9 @@ private:
     UFUNCTION(Server, Reliable)
     void ServerSwapButtonPressed();
 
-    UFUNCTION(NetMulticast, Reliable)
-    void MulticastHitReactMontage(AActor* DamageCauser);
+    // Cosmetic and sent once per damaged frame, losing one is fine
+    UFUNCTION(NetMulticast, Unreliable)
+    void MulticastHitReactMontage(const FVector_NetQuantize& DamageCauserLocation);
 
     void HideCharacterIfCameraClose();
 
@@ -317,7 +360,6 @@ private:
 
     void SetDynamicDissolveMaterialInstance(float Dissolve, float Glow);
 
-    void SetUpHitShapesSSR();
 
     UPROPERTY(VisibleAnywhere, Category = Camera)
     USpringArmComponent* CameraBoom;
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "HitBoxSet.generated.h"
+
+class UPhysicalMaterial;
+
+USTRUCT(BlueprintType)
+struct FHitBoxDefinition
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY(EditDefaultsOnly)
+    FName BoneName;
+
+    // Box transform relative to the bone
+    UPROPERTY(EditDefaultsOnly)
+    FVector LocalOffset = FVector::ZeroVector;
+
+    UPROPERTY(EditDefaultsOnly)
+    FRotator LocalRotation = FRotator::ZeroRotator;
+
+    // Half size, not scaled by the bone
+    UPROPERTY(EditDefaultsOnly)
+    FVector Extent = FVector(32.f);
+
+    // Selects the damage modifier of hits on the box
+    UPROPERTY(EditDefaultsOnly)
+    UPhysicalMaterial* PhysMaterial = nullptr;
+};
+
+/**
+ * Server-side rewind hit boxes of a character as data. Their world transforms are computed from the skeletal pose
+ * only when the rewind records a frame or confirms a hit, no scene component follows the bones.
+ */
+UCLASS(BlueprintType)
+class BLASTER_API UHitBoxSet : public UPrimaryDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    UHitBoxSet();
+
+    // Indexed by HitBox::Slot
+    UPROPERTY(EditDefaultsOnly, EditFixedSize)
+    TArray<FHitBoxDefinition> HitBoxes;
+};
@@ -9,6 +9,10 @@
 class UStaticMeshComponent;
 class USoundBase;
 
+/**
+ * Shell casing. Weapons don't spawn it, the casing subsystem ejects casings drawn with its mesh, pushed by its
+ * ejection impulse and ringing with its sound. Spawned on its own it is still a physics simulated casing
+ */
 UCLASS()
 class BLASTER_API ACasing : public AActor
 {
@@ -33,4 +37,9 @@ private:
 
     UPROPERTY(EditAnywhere)
     USoundBase* ShellSound;
+
+public:
+    FORCEINLINE UStaticMeshComponent* GetCasingMesh() const { return CasingMesh; };
+    FORCEINLINE float GetShellEjectionImpulse() const { return ShellEjectionImpulse; };
+    FORCEINLINE USoundBase* GetShellSound() const { return ShellSound; };
 };
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Weapon.h"
 #include "CarryItemTypes.h"
+#include "ImpactSubsystem.h"
 #include "HitScanWeapon.generated.h"
 
 class UParticleSystem;
@@ -20,15 +21,16 @@ public:
     virtual void Fire(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation) override;
 
 protected:
+    virtual void BeginPlay() override;
+
     void WeaponTraceHit(const FVector& TraceStart, const FVector_NetQuantize100& HitTarget, FHitResult& OutHit);
-    virtual void SpawnImpactFXAndSound(FHitResult& FireHit);
-    virtual void SpawnImpactParticles(FHitResult& FireHit, FImpactData& ImpactData);
-    virtual void SpawnImpactSound(FHitResult& FireHit, FImpactData& ImpactData);
-    virtual void SpawnImpactDecal(FHitResult& FireHit, FImpactData& ImpactData);
+    // Hands the impact to the impact subsystem, which spawns the frame's impacts together
+    void SpawnImpactFXAndSound(FHitResult& FireHit);
+    virtual FImpactEvent MakeImpactEvent(const FHitResult& FireHit);
 
     FTransform GetLocalWeaponSocketTransform();
 
-    FImpactData GetImpactData(FHitResult& FireHit);
+    const FImpactData& GetImpactData(const FHitResult& FireHit) const;
 
     UPROPERTY(EditAnywhere)
     FImpactData DefaultImpactData;
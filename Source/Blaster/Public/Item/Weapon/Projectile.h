@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "CarryItemTypes.h"
+#include "ImpactSubsystem.h"
 #include "Projectile.generated.h"
 
 class UStaticMeshComponent;
@@ -41,9 +42,25 @@ public:
     UPROPERTY(EditAnywhere, Category = "Movement")
     float GravityScale = 1.f;
 
+    /**
+     * Projectile pool hooks. Activation re-arms a projectile placed at its muzzle as if it was just spawned,
+     * deactivation hides it and stops its movement, collision, timers and FX. Reset clears what the last shot set
+     */
+    virtual void ActivateProjectile();
+    virtual void DeactivateProjectile();
+    virtual void ResetProjectile();
+
+    // Prewarmed projectiles begin play deactivated
+    bool bStartDeactivated = false;
+
 protected:
     virtual void BeginPlay() override;
 
+    // Gives the projectile back to the pool instead of destroying it
+    void DestroyProjectile();
+
+    virtual UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovementComponent; };
+
     void StartDestoryTimer();
 
     virtual void DestroyTimerFinished();
@@ -52,10 +69,9 @@ protected:
 
     void ExplodeDamage(const FVector& ImpactPoint);
 
-    virtual void SpawnImpactFXAndSound(const FHitResult& Hit);
-    virtual void SpawnImpactParticles(const FHitResult& FireHit, FImpactData& ImpactData);
-    virtual void SpawnImpactSound(const FHitResult& FireHit, FImpactData& ImpactData);
-    virtual void SpawnImpactDecal(const FHitResult& FireHit, FImpactData& ImpactData);
+    // Hands the impact to the impact subsystem, which spawns the frame's impacts together
+    void SpawnImpactFXAndSound(const FHitResult& Hit);
+    virtual FImpactEvent MakeImpactEvent(const FHitResult& FireHit);
 
     UFUNCTION()
     virtual void OnHit(
@@ -95,7 +111,7 @@ protected:
     AWeapon* OwningWeapon;
 
 private:
-    FImpactData GetImpactData(const FHitResult& FireHit);
+    const FImpactData& GetImpactData(const FHitResult& FireHit) const;
 
     UPROPERTY(EditAnywhere)
     UParticleSystem* Tracer;
@@ -104,6 +120,7 @@ private:
     UParticleSystemComponent* TracerComponent;
 
     FTimerHandle DestroyTimer;
+    FTimerHandle LifeSpanTimer;
 
     UPROPERTY(EditAnywhere)
     float DestroyTime = 3.f;
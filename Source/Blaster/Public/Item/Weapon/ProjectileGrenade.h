@@ -16,6 +16,8 @@ class BLASTER_API AProjectileGrenade : public AProjectile
 public:
     AProjectileGrenade();
 
+    virtual void ActivateProjectile() override;
+
 #if WITH_EDITOR
     virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
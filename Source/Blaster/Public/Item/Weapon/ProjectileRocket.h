@@ -18,6 +18,9 @@ UCLASS() class BLASTER_API AProjectileRocket : public AProjectile
 public:
     AProjectileRocket();
 
+    virtual void ActivateProjectile() override;
+    virtual void DeactivateProjectile() override;
+
 #if WITH_EDITOR
     virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
@@ -26,7 +29,7 @@ protected:
     virtual void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse,
         const FHitResult& Hit) override;
 
-    virtual void BeginPlay() override;
+    virtual UProjectileMovementComponent* GetProjectileMovement() const override;
 
     UPROPERTY()
     UAudioComponent* ProjectileLoopComponent;
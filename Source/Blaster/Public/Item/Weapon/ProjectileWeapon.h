@@ -16,6 +16,9 @@ class BLASTER_API AProjectileWeapon : public AWeapon
 public:
     virtual void Fire(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation) override;
 
+protected:
+    virtual void BeginPlay() override;
+
 private:
     void SetProjectileSSR(AProjectile* SpawnedProjectile, APawn* InstigatorPawn, FVector_NetQuantize TraceStart);
 
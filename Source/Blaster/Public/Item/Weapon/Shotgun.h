@@ -12,11 +12,20 @@ class BLASTER_API AShotgun : public AHitScanWeapon
     GENERATED_BODY()
 
 public:
-    virtual void FireShotgun(const TArray<FVector_NetQuantize100>& HitTargets, const FVector_NetQuantize100& SocketLocation);
-    void ShotgunTraceEndWithScatter(const FVector& HitTarget, TArray<FVector_NetQuantize100>& HitTargets);
+    virtual void FireShotgun(const FVector_NetQuantize100& HitTarget, const FVector_NetQuantize100& SocketLocation, int32 ScatterSeed);
+
+    // Pellet trace ends of one shot, regenerated from the seed by the server and the simulated proxies
+    void ShotgunTraceEndWithScatter(
+        const FVector& HitTarget, const FVector& TraceStart, int32 ScatterSeed, TArray<FVector_NetQuantize100>& HitTargets);
+
+    /**
+     * Rounds the shot's aim and muzzle to what survives the wire, so the pellets the owning client rolls
+     * are bit-exactly the ones the others regenerate. The muzzle goes to whole units, as the hit claim sends it
+     */
+    static void QuantizeScatterInputs(FVector_NetQuantize100& HitTarget, FVector_NetQuantize100& TraceStart);
 
 protected:
-    virtual void SpawnImpactSound(FHitResult& FireHit, FImpactData& ImpactData) override;
+    virtual FImpactEvent MakeImpactEvent(const FHitResult& FireHit) override;
 
 private:
     void ApplyMultipleDamage(                          //
@@ -24,7 +33,8 @@ private:
         APawn* OwnerPawn,                              //
         AController* InstigatorController,             //
         const FVector& Start,                          //
-        const TArray<FVector_NetQuantize100>& HitTargets  //
+        const FVector& HitTarget,                      //
+        int32 ScatterSeed                              //
     );
 
     void AddToHitMap(FHitResult& FireHit, TMap<ABlasterCharacter*, float>& OutHitMap);
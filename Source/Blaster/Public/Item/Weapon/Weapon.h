@@ -32,7 +32,13 @@ public:
 
     void AddAmmo(int32 AmmoToAdd);
 
+    // Server: the owner predicted a shot the server dropped, its client takes the round back
+    void RefundRejectedRound();
+
     FVector TraceEndWithScatter(const FVector& HitTarget, const FVector& TraceStart);
+
+    // Same scatter drawn from Stream, the same seed gives the same trace end on every machine
+    FVector TraceEndWithScatter(const FVector& HitTarget, const FVector& TraceStart, const FRandomStream& Stream);
     FVector GetTraceStart();
 
     /**
@@ -118,6 +124,9 @@ protected:
     UPROPERTY(Replicated, EditAnywhere)
     bool bUseServerSideRewind = false;
 
+    // Seconds the shot being fired was due before this frame, server-side rewind claims rewind that much further
+    float ShotTimeOffset = 0.f;
+
     UPROPERTY(EditAnywhere)
     bool bUseServerSideRewindDefault = false;
 
@@ -181,4 +190,5 @@ public:
     FORCEINLINE float GetAllowedGapToWall() const { return AllowedGapToWall; };
     FORCEINLINE float GetAimSensitivity() const { return AimSensitivity; };
     FORCEINLINE void SetScatter(bool IsScatter) { bUseScatter = IsScatter; };
+    FORCEINLINE void SetShotTimeOffset(float Offset) { ShotTimeOffset = Offset; };
 };
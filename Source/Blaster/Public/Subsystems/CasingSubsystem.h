@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CasingSubsystem.generated.h"
+
+class ACasing;
+class AActor;
+class UStaticMesh;
+class USoundBase;
+class UHierarchicalInstancedStaticMeshComponent;
+
+/**
+ * Casings of one mesh: one instance per casing, the simulation state at the same index as the instance
+ */
+USTRUCT()
+struct FCasingBatch
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY()
+    UHierarchicalInstancedStaticMeshComponent* Instances = nullptr;
+
+    UPROPERTY()
+    USoundBase* ShellSound = nullptr;
+
+    FVector Scale = FVector::OneVector;
+
+    TArray<FVector> Locations;
+    TArray<FVector> Velocities;
+    TArray<FQuat> Rotations;
+
+    // Rotation axis times radians per second
+    TArray<FVector> Spins;
+
+    // Height of the ground under the ejection point, probed once at spawn
+    TArray<float> GroundHeights;
+    TArray<float> Ages;
+    TArray<bool> bLanded;
+    TArray<bool> bResting;
+};
+
+/**
+ * Ejected shell casings without actors or physics bodies. Casings follow a ballistic path with drag, bounce on
+ * the ground height probed when they were ejected and are drawn through one instanced mesh per casing mesh.
+ * The casing classes of the weapons are only read for their mesh, ejection impulse and sound.
+ */
+UCLASS(Config = Game)
+class BLASTER_API UCasingSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual void Deinitialize() override;
+
+    void EjectCasing(TSubclassOf<ACasing> CasingClass, const FTransform& EjectTransform, const AActor* IgnoredActor);
+
+private:
+    FCasingBatch* FindOrAddBatch(UStaticMesh* Mesh, USoundBase* ShellSound);
+    void RemoveCasing(FCasingBatch& Batch, int32 Index);
+
+    // Spends one of the second's shell sounds, false once the budget is gone
+    bool ConsumeSoundBudget();
+
+    UPROPERTY()
+    AActor* InstancesOwner = nullptr;
+
+    UPROPERTY()
+    TMap<UStaticMesh*, FCasingBatch> Batches;
+
+    TArray<FTransform> TransformsScratch;
+
+    float SoundBudget = 0.f;
+
+    UPROPERTY(Config)
+    float CasingLifeTime = 3.f;
+
+    // Oldest casings of a batch make room for new ones past this
+    UPROPERTY(Config)
+    int32 MaxCasingsPerBatch = 256;
+
+    // Ejection speed in cm/s for each unit of the casing's ejection impulse
+    UPROPERTY(Config)
+    float EjectionSpeedPerImpulse = 40.f;
+
+    UPROPERTY(Config)
+    float EjectionConeDegrees = 20.f;
+
+    UPROPERTY(Config)
+    float MaxSpinSpeed = 30.f;
+
+    // Velocity lost per second to the air
+    UPROPERTY(Config)
+    float Drag = 0.5f;
+
+    // Vertical speed kept by a bounce, and horizontal speed kept on contact
+    UPROPERTY(Config)
+    float Restitution = 0.3f;
+
+    UPROPERTY(Config)
+    float GroundFriction = 0.6f;
+
+    // Casings bouncing slower than this come to rest
+    UPROPERTY(Config)
+    float RestSpeed = 20.f;
+
+    UPROPERTY(Config)
+    float GroundProbeDistance = 500.f;
+
+    // Shell sounds per second over the whole world, the budget refills continuously
+    UPROPERTY(Config)
+    float ShellSoundsPerSecond = 8.f;
+};
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DamageQueueSubsystem.generated.h"
+
+class ABlasterCharacter;
+class AController;
+
+/**
+ * Damage one attacker dealt to a character within a frame
+ */
+USTRUCT()
+struct FQueuedDamage
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY()
+    AController* InstigatedBy = nullptr;
+
+    // Causer of the attacker's biggest hit, the hit reaction faces it
+    UPROPERTY()
+    AActor* DamageCauser = nullptr;
+
+    float Damage = 0.f;
+    float BiggestHit = 0.f;
+};
+
+USTRUCT()
+struct FVictimDamage
+{
+    GENERATED_USTRUCT_BODY()
+
+    // One entry per attacker, in the order they first hit
+    UPROPERTY()
+    TArray<FQueuedDamage> Attackers;
+};
+
+/**
+ * Server side damage of a frame. Characters queue the damage events they take, pellets, explosions and confirmed
+ * rewind hits alike, and apply them once per frame: one damage calculation per attacker, one health and shield
+ * change, one HUD update and one hit reaction per character.
+ */
+UCLASS()
+class BLASTER_API UDamageQueueSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual void Deinitialize() override;
+
+    void QueueDamage(ABlasterCharacter* Victim, float Damage, AController* InstigatedBy, AActor* DamageCauser);
+
+private:
+    void FlushDamage();
+
+    UPROPERTY()
+    TMap<ABlasterCharacter*, FVictimDamage> PendingDamage;
+
+    // Swapped with PendingDamage while flushing, damage queued during the flush waits for the next frame
+    UPROPERTY()
+    TMap<ABlasterCharacter*, FVictimDamage> FlushingDamage;
+};
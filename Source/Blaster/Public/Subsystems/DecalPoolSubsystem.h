@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DecalPoolSubsystem.generated.h"
+
+class AActor;
+class UDecalComponent;
+class UPhysicalMaterial;
+struct FDecalData;
+
+/**
+ * A pooled decal and the world time it has faded out at
+ */
+USTRUCT()
+struct FPooledDecal
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY()
+    UDecalComponent* Decal = nullptr;
+
+    double ExpireTime = 0.0;
+};
+
+/**
+ * Decals of one physical material, oldest at Next once the ring is full
+ */
+USTRUCT()
+struct FDecalRing
+{
+    GENERATED_USTRUCT_BODY()
+
+    UPROPERTY()
+    TArray<FPooledDecal> Decals;
+
+    int32 Next = 0;
+};
+
+/**
+ * Impact decals of the world, recycled instead of spawned. Each physical material keeps a ring of decals that reuses
+ * its oldest decal once full, and all rings together stay under a global cap by taking the oldest decal of the
+ * fullest ring. Decals fade out with their life time and with distance through their fade screen size. The pool
+ * drives the fade itself and hides faded decals, the engine's fade out would destroy the pooled components.
+ */
+UCLASS(Config = Game)
+class BLASTER_API UDecalPoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    void SpawnDecal(const FDecalData& DecalData, UPhysicalMaterial* PhysMaterial, const FVector& Location, const FRotator& Rotation);
+
+private:
+    FPooledDecal* TakeDecal(FDecalRing& Ring);
+    UDecalComponent* CreateDecal();
+    void HideExpiredDecals();
+
+    // Owns every decal
+    UPROPERTY()
+    AActor* DecalsOwner;
+
+    // One ring per physical material, decals without one share the null ring
+    UPROPERTY()
+    TMap<UPhysicalMaterial*, FDecalRing> Rings;
+
+    // Live decals across all rings
+    int32 NumDecals = 0;
+
+    FTimerHandle HideExpiredTimer;
+
+    UPROPERTY(Config)
+    int32 RingSizePerMaterial = 48;
+
+    UPROPERTY(Config)
+    int32 MaxDecals = 192;
+
+    // Screen size the decals fade out below, so far decals cost nothing
+    UPROPERTY(Config)
+    float FadeScreenSize = 0.01f;
+
+    // How often faded decals are looked for and hidden
+    UPROPERTY(Config)
+    float HideExpiredInterval = 1.f;
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FXPoolSubsystem.generated.h"
+
+class AActor;
+class UFXSystemAsset;
+class UFXSystemComponent;
+class UParticleSystem;
+class UParticleSystemComponent;
+class UNiagaraSystem;
+class UNiagaraComponent;
+class USceneComponent;
+
+enum class EFXPoolMethod : uint8
+{
+    // Back to the pool when the effect finishes, the caller must not keep the component
+    AutoRelease,
+
+    // The caller keeps the component until it gives it back with ReleaseFX
+    ManualRelease
+};
+
+USTRUCT()
+struct FFXComponentPool
+{
+    GENERATED_USTRUCT_BODY()
+
+    // Registered, deactivated components of the asset
+    UPROPERTY()
+    TArray<UFXSystemComponent*> Free;
+
+    // In activation order, the oldest is reclaimed when the asset is at its cap
+    UPROPERTY()
+    TArray<UFXSystemComponent*> ActiveAuto;
+
+    UPROPERTY()
+    TArray<UFXSystemComponent*> ActiveManual;
+};
+
+/**
+ * Reuses the particle and Niagara components of short effects, one pool per effect asset. Components are
+ * created and registered when the pool is prewarmed or grows, and only moved and reactivated when played.
+ * Dedicated servers play nothing.
+ */
+UCLASS(Config = Game)
+class BLASTER_API UFXPoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    UParticleSystemComponent* SpawnEmitterAtLocation(UParticleSystem* Template,  //
+        const FTransform& Transform,                                          //
+        EFXPoolMethod PoolMethod = EFXPoolMethod::AutoRelease);
+
+    UNiagaraComponent* SpawnSystemAttached(UNiagaraSystem* System,  //
+        USceneComponent* AttachToComponent,                         //
+        const FVector& Location,                                    //
+        const FRotator& Rotation,                                   //
+        EFXPoolMethod PoolMethod = EFXPoolMethod::AutoRelease);
+
+    // Gives back a manually released component, deactivating it. Safe with null
+    void ReleaseFX(UFXSystemComponent* Component);
+
+    // Creates components of the asset up to Count free ones, PrewarmCount when Count is 0
+    void Prewarm(UFXSystemAsset* Asset, int32 Count = 0);
+
+private:
+    UFXSystemComponent* AcquireComponent(UFXSystemAsset* Asset, EFXPoolMethod PoolMethod);
+    UFXSystemComponent* CreateComponent(UFXSystemAsset* Asset);
+    void ReturnToPool(UFXSystemComponent* Component);
+    bool CanPlayFX() const;
+
+    UFUNCTION()
+    void OnParticleSystemFinished(UParticleSystemComponent* Component);
+
+    UFUNCTION()
+    void OnNiagaraSystemFinished(UNiagaraComponent* Component);
+
+    // Owns every pooled component
+    UPROPERTY()
+    AActor* ComponentsOwner;
+
+    UPROPERTY()
+    TMap<UFXSystemAsset*, FFXComponentPool> Pools;
+
+    UPROPERTY(Config)
+    int32 PrewarmCount = 4;
+
+    // Active components of one asset, auto released ones are reclaimed past it
+    UPROPERTY(Config)
+    int32 MaxActivePerAsset = 24;
+
+    UPROPERTY(Config)
+    int32 MaxFreePerAsset = 32;
+};
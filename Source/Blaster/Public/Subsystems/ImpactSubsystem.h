@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CarryItemTypes.h"
+#include "ImpactSubsystem.generated.h"
+
+class UParticleSystem;
+class USoundBase;
+class UPhysicalMaterial;
+
+/**
+ * One impact to show: what the surface plays and where
+ */
+USTRUCT()
+struct FImpactEvent
+{
+    GENERATED_USTRUCT_BODY()
+
+    // Effect and decal on the hit point, facing out of the surface
+    static FImpactEvent Make(const FImpactData& ImpactData, const FHitResult& Hit);
+
+    UPROPERTY()
+    UParticleSystem* ImpactParticles = nullptr;
+
+    UPROPERTY()
+    USoundBase* ImpactSound = nullptr;
+
+    UPROPERTY()
+    FDecalData DecalData;
+
+    // Hit material, impacts are merged and budgeted per material
+    UPROPERTY()
+    UPhysicalMaterial* PhysMaterial = nullptr;
+
+    // Particles and sound
+    FVector EffectLocation = FVector::ZeroVector;
+    FRotator EffectRotation = FRotator::ZeroRotator;
+
+    bool bSpawnDecal = true;
+    FVector DecalLocation = FVector::ZeroVector;
+    FRotator DecalRotation = FRotator::ZeroRotator;
+
+    float SoundVolume = 1.f;
+    float SoundPitch = 1.f;
+
+    // Impacts merged into this one, each makes the sound louder
+    int32 Count = 1;
+};
+
+/**
+ * Collects the impacts of a frame and shows them once per frame. Nearby impacts of the same material and effects
+ * merge into one, the rest are ranked by distance to the local view and spawned within per-frame and per-material
+ * budgets. Far impacts are dropped, particles out of view too. Dedicated servers show nothing.
+ */
+UCLASS(Config = Game)
+class BLASTER_API UImpactSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    // False on dedicated servers, lets callers skip building the impact
+    bool WantsImpacts() const;
+
+    void QueueImpact(const FImpactEvent& Impact);
+
+private:
+    void FlushImpacts();
+    void SpawnImpact(const FImpactEvent& Impact, bool bInView);
+
+    UPROPERTY()
+    TArray<FImpactEvent> PendingImpacts;
+
+    // Pending impact indices sorted by distance to the view
+    TArray<TPair<double, int32>> RankScratch;
+
+    // Impacts spawned per material in the current flush
+    TMap<const UPhysicalMaterial*, int32> MaterialCountsScratch;
+
+    UPROPERTY(Config)
+    int32 MaxImpactsPerFrame = 8;
+
+    UPROPERTY(Config)
+    int32 MaxImpactsPerMaterialPerFrame = 4;
+
+    // Past this the frame's further impacts are dropped without merging
+    UPROPERTY(Config)
+    int32 MaxPendingImpacts = 64;
+
+    UPROPERTY(Config)
+    float MergeRadius = 40.f;
+
+    UPROPERTY(Config)
+    float MaxImpactDistance = 6000.f;
+
+    // Volume added per merged impact, up to MaxMergedVolumeScale times the impact's volume
+    UPROPERTY(Config)
+    float MergedVolumePerImpact = 0.15f;
+
+    UPROPERTY(Config)
+    float MaxMergedVolumeScale = 2.f;
+
+    // Closer than this particles play even out of view, they may be seen right away
+    UPROPERTY(Config)
+    float AlwaysVisibleDistance = 600.f;
+
+    // Half angle of the cone around the view direction considered in view
+    UPROPERTY(Config)
+    float ViewConeDegrees = 70.f;
+};
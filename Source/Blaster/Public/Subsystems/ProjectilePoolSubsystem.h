@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+class AProjectile;
+
+USTRUCT()
+struct FProjectilePool
+{
+    GENERATED_USTRUCT_BODY()
+
+    // Deactivated projectiles waiting to be fired again
+    UPROPERTY()
+    TArray<AProjectile*> Free;
+};
+
+/**
+ * Keeps spent bullets, rockets and grenades of the world to fire them again, one pool per projectile class.
+ * Projectiles aren't replicated, every machine pools its own.
+ */
+UCLASS(Config = Game)
+class BLASTER_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    // Takes a free projectile of the class or spawns one, then activates it at the location as if just spawned
+    AProjectile* AcquireProjectile(TSubclassOf<AProjectile> ProjectileClass,  //
+        const FVector& Location,                                             //
+        const FRotator& Rotation,                                            //
+        AActor* Owner,                                                       //
+        APawn* Instigator);
+
+    // Deactivates the projectile and keeps it for the next shot, destroys it if the pool is full
+    void ReleaseProjectile(AProjectile* Projectile);
+
+    // Spawns deactivated projectiles until the class has PrewarmCount free ones
+    void Prewarm(TSubclassOf<AProjectile> ProjectileClass);
+
+private:
+    AProjectile* SpawnProjectile(TSubclassOf<AProjectile> ProjectileClass,  //
+        const FVector& Location,                                           //
+        const FRotator& Rotation,                                          //
+        AActor* Owner,                                                     //
+        APawn* Instigator,                                                 //
+        bool bStartDeactivated);
+
+    UPROPERTY()
+    TMap<UClass*, FProjectilePool> Pools;
+
+    UPROPERTY(Config)
+    int32 PrewarmCount = 8;
+
+    // Free projectiles kept per class, the rest of a burst is destroyed
+    UPROPERTY(Config)
+    int32 MaxFreePerClass = 64;
+};
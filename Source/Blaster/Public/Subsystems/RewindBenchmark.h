@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+class URewindSubsystem;
+class ABlasterCharacter;
+class AWeapon;
+
+/**
+ * Measures the server-side rewind path on synthetic histories, for 8, 16, 32 and 64 characters.
+ * Runs from the console on a server or standalone game, headless with -nullrhi:
+ * -ExecCmds="Blaster.RewindBenchmark [Iterations]". Results are written to Saved/Profiling/Blaster as CSV.
+ */
+class FRewindBenchmark
+{
+public:
+    static void Run(UWorld* World, int32 Iterations);
+
+private:
+    struct FSamples
+    {
+        FString Operation;
+        TArray<double> Seconds;
+    };
+
+    static void RunForPlayerCount(UWorld* World, int32 PlayerCount, int32 Iterations, FString& OutCsv);
+
+    // Fills every character's history with moving poses over the whole record window
+    static void RecordSyntheticHistories(URewindSubsystem* RewindSubsystem, const TArray<ABlasterCharacter*>& Characters, float Now);
+
+    static void AppendCsvRow(int32 PlayerCount, const FSamples& Samples, FString& OutCsv);
+};
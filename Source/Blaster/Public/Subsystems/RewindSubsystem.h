@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationComponent.h"
+#include "RewindSubsystem.generated.h"
+
+class ABlasterCharacter;
+
+/**
+ * Frame package packed for the history: positions are int16 relative to the center of the frame's bounds
+ * and rotations are smallest-three quaternions in 32 bits. Box extents don't change and live in the history.
+ */
+struct FCompressedFrame
+{
+    float Time = 0.f;
+
+    // Last time the same pose was recorded, unchanged poses extend the newest frame instead of adding one
+    float EndTime = 0.f;
+
+    FVector Root = FVector::ZeroVector;
+
+    int16 Locations[HitBox::Num][3];
+    uint32 Rotations[HitBox::Num];
+
+    int16 BoundsMin[3];
+    int16 BoundsMax[3];
+    bool bHasBounds = false;
+};
+
+/**
+ * Fixed-capacity circular buffer of compressed frames, ordered from the oldest to the newest.
+ * Storage is allocated once in Init, recording a frame reuses the slot of the oldest one. Frames are decoded only on rewind.
+ */
+class FFrameHistory
+{
+public:
+    void Init(int32 InCapacity);
+    void Reset();
+
+    // Reallocates the storage, keeping the newest frames that fit
+    void SetCapacity(int32 InCapacity);
+
+    /**
+     * Compresses the package into the newest frame, overwriting the oldest frame when the buffer is full.
+     * If the pose didn't change since the newest frame only its EndTime moves, returns false then
+     */
+    bool AddNewest(const FFramePackage& Package);
+    void RemoveOldest();
+
+    // Index of the first frame younger than Time, Num() if there is none. O(log n)
+    int32 UpperBound(float Time) const;
+
+    // 0 is the oldest frame, Num() - 1 is the newest. The decoded package has no Character
+    void Decode(int32 Index, FFramePackage& OutPackage) const;
+    FBox GetBounds(int32 Index) const;
+
+    FORCEINLINE float GetTime(int32 Index) const { return GetFrame(Index).Time; };
+    FORCEINLINE float GetEndTime(int32 Index) const { return GetFrame(Index).EndTime; };
+    FORCEINLINE float GetOldestTime() const { return GetTime(0); };
+    FORCEINLINE float GetNewestTime() const { return GetEndTime(Count - 1); };
+
+    FORCEINLINE int32 Num() const { return Count; };
+    FORCEINLINE int32 Capacity() const { return Frames.Num(); };
+    FORCEINLINE bool IsEmpty() const { return Count == 0; };
+
+private:
+    FORCEINLINE const FCompressedFrame& GetFrame(int32 Index) const
+    {
+        checkSlow(Index >= 0 && Index < Count);
+        return Frames[(Head + Index) % Frames.Num()];
+    };
+
+    void Encode(const FFramePackage& Package, FCompressedFrame& OutFrame);
+
+    // Equal within one quantization step
+    static bool IsSamePose(const FCompressedFrame& A, const FCompressedFrame& B);
+
+    TArray<FCompressedFrame> Frames;
+
+    // Shared by every frame, refreshed on each record
+    FVector BoxExtents[HitBox::Num];
+
+    // Slot of the oldest frame
+    int32 Head = 0;
+    int32 Count = 0;
+};
+
+/**
+ * Owns the hit box history of every character on the server.
+ * All registered characters are recorded in one pass after the world has ticked, rewind queries are answered here.
+ */
+UCLASS(Config = Game)
+class BLASTER_API URewindSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+    // Fills synthetic histories and times the private steps
+    friend class FRewindBenchmark;
+
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    void RegisterCharacter(ABlasterCharacter* Character);
+    void UnregisterCharacter(ABlasterCharacter* Character);
+
+    // Requests are confirmed together once per tick, before the new frame is recorded
+    void QueueScoreRequest(FScoreRequest&& Request);
+
+    /**
+     * Hit boxes of the character at HitTime, an empty package (no Character) if the history doesn't reach that far.
+     * HitTime is quantized by HitTimeQuantum and frames are memoized for the batch being processed
+     */
+    FFramePackage GetFrameToCheck(ABlasterCharacter* HitCharacter, float HitTime);
+
+    /**
+     * Bounds of the recorded frames around HitTime, nothing is interpolated.
+     * False if the history doesn't reach that far, GetFrameToCheck would return an empty package then
+     */
+    bool GetBoundsToCheck(const ABlasterCharacter* HitCharacter, float HitTime, FBox& OutBounds) const;
+
+    FORCEINLINE float GetMaxRecordTime() const { return MaxRecordTime; };
+    FORCEINLINE float GetRecordTime() const { return RecordTime; };
+
+private:
+    void ProcessScoreRequests();
+    void ApplyDamageBatch();
+
+    FFramePackage RewindFrame(ABlasterCharacter* HitCharacter, float HitTime) const;
+
+    void RecordFrame(ABlasterCharacter* Character, FFrameHistory& History, float Time);
+
+    // Sizes the history window to the worst latency seen recently and resizes the histories to match
+    void UpdateRecordTime(float DeltaTime);
+
+    FFramePackage InterpBetweenFrames(      //
+        const FFramePackage& OlderFrame,    //
+        const FFramePackage& YoungerFrame,  //
+        float HitTime) const;
+
+    int32 GetHistoryCapacity() const;
+
+    FORCEINLINE int32 GetTimeKey(float HitTime) const { return FMath::RoundToInt(HitTime / HitTimeQuantum); };
+
+    /**
+     * Registered characters and their histories, the same index in both arrays
+     */
+    UPROPERTY()
+    TArray<ABlasterCharacter*> Characters;
+
+    TArray<FFrameHistory> Histories;
+
+    TArray<FScoreRequest> PendingScoreRequests;
+    FRewindDamageBatch DamageBatch;
+
+    // Rewound frames of the current batch, keyed by character and quantized hit time
+    TMap<TPair<const ABlasterCharacter*, int32>, FFramePackage> FrameCache;
+
+    // History window, adapted between MinRecordTime and MaxRecordTime
+    float RecordTime = 0.f;
+
+    // Worst round trip or rewind depth seen recently, in seconds
+    float PeakLatency = 0.f;
+
+    float NextRecordTime = 0.f;
+
+    UPROPERTY(Config)
+    float MaxRecordTime = 4.f;
+
+    UPROPERTY(Config)
+    float MinRecordTime = 0.5f;
+
+    // Added to the peak latency for the client's interpolation delay and jitter
+    UPROPERTY(Config)
+    float RecordTimeMargin = 0.25f;
+
+    // How fast the peak latency falls back once the laggy players are gone, in seconds per second
+    UPROPERTY(Config)
+    float LatencyDecayRate = 0.1f;
+
+    // Seconds between two recorded frames, 0 records every server tick
+    UPROPERTY(Config)
+    float RecordInterval = 1.f / 60.f;
+
+    // Hit times closer than this share one rewound frame
+    UPROPERTY(Config)
+    float HitTimeQuantum = 0.001f;
+
+    // Added around the bounds of the bracketing frames to cover the hit boxes of slerped rotations
+    UPROPERTY(Config)
+    float BoundsMargin = 5.f;
+
+    // Used to size the histories when there is no net driver to read the server tick rate from
+    UPROPERTY(Config)
+    float DefaultServerTickRate = 120.f;
+
+    // Smaller batches are solved on the game thread, dispatching them costs more than solving them
+    UPROPERTY(Config)
+    int32 MinJobsToParallelize = 4;
+};